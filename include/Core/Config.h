@@ -3,11 +3,20 @@
 #ifndef FT_INCLUDE_CORE_CONFIG_H_
 #define FT_INCLUDE_CORE_CONFIG_H_
 
+#include <map>
 #include <string>
 #include <vector>
 
 namespace ft {
 
+/*
+ * 报单流控在throttle_period_ms内允许的报单笔数和报单数量，为0表示不限制
+ */
+struct ThrottleLimit {
+  uint64_t order_limit = 0;
+  uint64_t volume_limit = 0;
+};
+
 class Config {
  public:
   std::string api{""};
@@ -22,6 +31,46 @@ class Config {
 
   bool cancel_outstanding_orders_on_startup = true;
 
+  // 交易引擎与策略之间的通讯方式，redis或shm
+  std::string ipc_transport{"redis"};
+
+  // 引擎在没有指令或订单事件时是忙等还是在futex上休眠
+  bool ipc_futex_wait = false;
+
+  // 引擎线程绑定的CPU核，小于0时不绑定
+  int engine_cpu_affinity = -1;
+
+  // 仓位写入redis的周期，为0时每次更新都同步写入
+  uint64_t position_flush_interval_ms = 0;
+
+  // 按最新价计算并发布浮动盈亏的周期，为0时不计算浮动盈亏
+  uint64_t pnl_publish_interval_ms = 500;
+
+  // 是否由单独的线程发布行情及订单回报，以及发布队列满时的处理方式
+  bool async_publish = false;
+  std::string publish_backpressure{"block"};
+
+  // 订单事件日志文件，为空时交给spdlog输出
+  std::string event_log_file{""};
+
+  // 是否统计订单链路各阶段的延迟，收到SIGUSR1时输出
+  bool latency_trace = false;
+
+  // 报单流控，分别对整个账户、每个策略及每个合约计数。策略和合约先查找
+  // 单独的设置，没有时使用默认设置
+  uint64_t throttle_period_ms = 1000;
+  ThrottleLimit account_throttle{2, 100};
+  ThrottleLimit strategy_throttle{};
+  std::map<std::string, ThrottleLimit> strategy_throttles{};
+  ThrottleLimit ticker_throttle{};
+  std::map<std::string, ThrottleLimit> ticker_throttles{};
+
+  // 限价单偏离最新价的最大跳数(price_tick)，为0时不检查
+  uint32_t price_band_ticks = 0;
+  // 单笔订单及单个合约所有在途订单的名义金额上限，为0表示不限制
+  double max_order_notional = 0;
+  double max_ticker_notional = 0;
+
   std::string arg0{""};
   std::string arg1{""};
   std::string arg2{""};
@@ -34,6 +34,32 @@ inline const std::string EX_SH_A = "SH";
 // 深圳证券交易所-A股
 inline const std::string EX_SZ_A = "SZ";
 
+/*
+ * 交易引擎与策略之间的通讯方式
+ */
+inline const std::string IPC_REDIS = "redis";
+inline const std::string IPC_SHM = "shm";
+
+/*
+ * 异步发布队列满时的处理方式
+ * block:    等待队列有空位
+ * drop:     丢弃新的行情
+ * conflate: 同一合约只保留最新的行情
+ */
+inline const std::string BACKPRESSURE_BLOCK = "block";
+inline const std::string BACKPRESSURE_DROP = "drop";
+inline const std::string BACKPRESSURE_CONFLATE = "conflate";
+
+/*
+ * 策略事件循环没有事件时的等待方式
+ * busy:     忙等，延迟最低但会占满一个CPU核
+ * blocking: 在poll上休眠直到有数据到达或定时器到期
+ * hybrid:   先忙等一段时间，仍没有事件再休眠
+ */
+inline const std::string EVENT_LOOP_BUSY = "busy";
+inline const std::string EVENT_LOOP_BLOCKING = "blocking";
+inline const std::string EVENT_LOOP_HYBRID = "hybrid";
+
 /*
  * 订单价格类型
  * 订单价格类型还需要继续细分
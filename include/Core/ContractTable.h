@@ -108,10 +108,14 @@ class ContractTable {
     if (!is_inited) {
       if (!load_contracts(file, &contracts)) return false;
 
+      // 行情topic在发布每个tick时都要用到，在这里一次性生成，
+      // 下标与ticker_index一致
+      quote_topics.resize(contracts.size() + 1);
       for (std::size_t i = 0; i < contracts.size(); ++i) {
         auto& contract = contracts[i];
         contract.index = i + 1;
         ticker2contract.emplace(contract.ticker, &contract);
+        quote_topics[contract.index] = fmt::format("quote-{}", contract.ticker);
       }
 
       is_inited = true;
@@ -131,8 +135,18 @@ class ContractTable {
     return &contracts[ticker_index - 1];
   }
 
+  static std::size_t size() { return contracts.size(); }
+
+  /*
+   * 须保证ticker_index有效
+   */
+  static const std::string& quote_topic(uint32_t ticker_index) {
+    return quote_topics[ticker_index];
+  }
+
  private:
   inline static std::vector<Contract> contracts;
+  inline static std::vector<std::string> quote_topics;
   inline static std::map<std::string, Contract*> ticker2contract;
 };
 
@@ -21,10 +21,14 @@ enum ErrorCode : int {
   ERR_POSITION_NOT_ENOUGH,
   ERR_FUND_NOT_ENOUGH,
   ERR_THROTTLE_RATE_LIMIT,
+  ERR_PRICE_LIMIT,      // 价格超出涨跌停板
+  ERR_PRICE_DEVIATION,  // 价格偏离最新价过多
+  ERR_NOTIONAL_LIMIT,   // 单笔或单合约的名义金额超限
 
   ERR_SEND_FAILED,
 
   ERR_REJECTED,
+  ERR_REPLACE_FAILED,  // 原订单已全部成交或撤单被拒，改单没有执行
   ERR_COUNT
 };
 
@@ -35,8 +39,12 @@ inline const char* error_code_str(int error_code) {
       "ERR_POSITION_NOT_ENOUGH",
       "ERR_FUND_NOT_ENOUGH",
       "ERR_THROTTLE_RATE_LIMIT",
+      "ERR_PRICE_LIMIT",
+      "ERR_PRICE_DEVIATION",
+      "ERR_NOTIONAL_LIMIT",
       "ERR_SEND_FAILED",
       "ERR_REJECTED",
+      "ERR_REPLACE_FAILED",
   };
 
   if (error_code < 0 || error_code >= ERR_COUNT) return "UNKNOWN_ERROR_CODE";
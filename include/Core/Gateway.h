@@ -41,6 +41,16 @@ class Gateway {
    */
   virtual uint64_t send_order(const OrderReq* order) { return 0; }
 
+  /*
+   * 批量发单，order_ids[i]为orders[i]的订单号，发单失败的为0。柜台支持
+   * 批量报单的Gateway可以重写此函数，默认逐笔调用send_order
+   */
+  virtual void send_order_batch(const OrderReq* orders, std::size_t count,
+                                uint64_t* order_ids) {
+    for (std::size_t i = 0; i < count; ++i)
+      order_ids[i] = send_order(&orders[i]);
+  }
+
   virtual bool cancel_order(uint64_t order_id) { return false; }
 
   virtual bool query_contract(const std::string& ticker,
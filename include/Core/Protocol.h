@@ -7,6 +7,9 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
+
+#include "Core/ContractTable.h"
 
 namespace ft {
 
@@ -31,6 +34,12 @@ struct OrderReq {
    */
   uint32_t user_order_id;
 
+  /*
+   * 发单策略的编号，见StrategyIdTable，0表示不属于任何策略。供风控按策略
+   * 统计使用，网关不需要关心
+   */
+  uint32_t strategy_index;
+
   uint32_t ticker_index;
   uint32_t type;
   uint32_t direction;
@@ -46,7 +55,28 @@ struct OrderReq {
 
 inline const uint32_t TRADER_CMD_MAGIC = 0x1709394;
 
-enum TraderCmdType { NEW_ORDER = 1, CANCEL_ORDER, CANCEL_TICKER, CANCEL_ALL };
+/*
+ * QUERY_ORDERS: 策略请求引擎重新推送该策略所有未完成订单的最新状态，
+ *               用于策略发现订单回报丢失或刚启动时同步订单状态
+ * CANCEL_STRATEGY: 撤销strategy_id所指策略的所有未完成订单
+ * NEW_ORDER_BATCH: 批量报单，order_batch.count个TraderOrderReq紧跟在
+ *                  TraderCommand之后，整个指令的长度见trader_cmd_size。
+ *                  引擎对整批订单一次完成风控检查并交给网关发送
+ * REPLACE_ORDER: 改单，引擎先撤销原订单，收到撤单回报后立即以新的价格
+ *                和数量发出新订单，策略不需要等待撤单回报
+ */
+enum TraderCmdType {
+  NEW_ORDER = 1,
+  CANCEL_ORDER,
+  CANCEL_TICKER,
+  CANCEL_ALL,
+  QUERY_ORDERS,
+  CANCEL_STRATEGY,
+  NEW_ORDER_BATCH,
+  REPLACE_ORDER
+};
+
+inline constexpr uint32_t kMaxBatchOrders = 256;
 
 struct TraderOrderReq {
   uint32_t user_order_id;
@@ -66,6 +96,26 @@ struct TraderCancelTickerReq {
   uint32_t ticker_index;
 } __attribute__((packed));
 
+struct TraderOrderBatchReq {
+  uint32_t count;
+} __attribute__((packed));
+
+/*
+ * volume为新订单的数量，为0时沿用原订单被撤销的数量。新订单的数量不会
+ * 超过原订单被撤销的数量，即原订单在撤单完成前已成交的部分会从中扣除，
+ * 改单不会增加总的成交敞口；
+ * user_order_id为新订单的user_order_id，为0时沿用原订单的。
+ * 原订单在撤单完成前全部成交或撤单被拒时改单不执行，引擎回复一条
+ * error_code为ERR_REPLACE_FAILED、order_id为原订单的回报，completed
+ * 表示原订单是否已结束
+ */
+struct TraderReplaceReq {
+  uint64_t order_id;
+  double price;
+  int volume;
+  uint32_t user_order_id;
+} __attribute__((packed));
+
 struct TraderCommand {
   uint32_t magic;
   uint32_t type;
@@ -74,9 +124,35 @@ struct TraderCommand {
     TraderOrderReq order_req;
     TraderCancelReq cancel_req;
     TraderCancelTickerReq cancel_ticker_req;
+    TraderOrderBatchReq order_batch;
+    TraderReplaceReq replace_req;
   };
+  uint64_t send_time_ns;  // 策略发出指令的时间(CLOCK_MONOTONIC)，0表示不追踪
+} __attribute__((packed));
+
+/*
+ * 能容纳最大批量报单指令的缓冲区
+ */
+struct TraderCmdBuffer {
+  TraderCommand cmd;
+  TraderOrderReq order_reqs[kMaxBatchOrders];
 } __attribute__((packed));
 
+/*
+ * 指令的完整长度，批量报单的数量不合法时返回0
+ */
+inline std::size_t trader_cmd_size(const TraderCommand* cmd) {
+  if (cmd->type != NEW_ORDER_BATCH) return sizeof(TraderCommand);
+  if (cmd->order_batch.count == 0 || cmd->order_batch.count > kMaxBatchOrders)
+    return 0;
+  return sizeof(TraderCommand) +
+         cmd->order_batch.count * sizeof(TraderOrderReq);
+}
+
+inline const TraderOrderReq* batch_order_reqs(const TraderCommand* cmd) {
+  return reinterpret_cast<const TraderOrderReq*>(cmd + 1);
+}
+
 /*
  *
  */
@@ -93,6 +169,22 @@ struct OrderResponse {
   int error_code;
   uint32_t this_traded;
   double this_traded_price;
+
+  /*
+   * 延迟追踪用，时间均为CLOCK_MONOTONIC，0表示未追踪。cmd_time_ns为
+   * 策略发出该订单的指令的时间，rsp_time_ns为引擎发出该回报的时间
+   */
+  uint64_t cmd_time_ns;
+  uint64_t rsp_time_ns;
+
+  /*
+   * QUERY_ORDERS的回复：每个未完成的订单一条snapshot为true的回报，最后以
+   * 一条order_id为0、snapshot_end为true的回报结束，snapshot_count为快照中
+   * 的订单数。策略本地未完成而快照中没有的订单已在此之前结束
+   */
+  bool snapshot;
+  bool snapshot_end;
+  uint32_t snapshot_count;
 } __attribute__((packed));
 
 class ProtocolQueryCenter {
@@ -104,21 +196,59 @@ class ProtocolQueryCenter {
     realized_pnl_key_ = fmt::format("rpnl-{}", account_abbreviation_);
     float_pnl_key_ = fmt::format("fpnl-{}", account_abbreviation_);
     pos_key_prefix_ = fmt::format("pos-{}-", account_abbreviation_);
+    quote_shm_name_ = fmt::format("/ft-quote-{}", account_abbreviation_);
+    trader_cmd_shm_name_ =
+        fmt::format("/ft-trader_cmd-{}", account_abbreviation_);
+    pos_shm_name_ = fmt::format("/ft-pos-{}", account_abbreviation_);
+    quote_table_shm_name_ =
+        fmt::format("/ft-quote_table-{}", account_abbreviation_);
+    metrics_shm_name_ = fmt::format("/ft-metrics-{}", account_abbreviation_);
+
+    // 仓位key在每次仓位变化时都要用到，提前为每个合约生成，
+    // 下标与ticker_index一致
+    pos_keys_.resize(ContractTable::size() + 1);
+    for (uint32_t i = 1; i < pos_keys_.size(); ++i)
+      pos_keys_[i] = pos_key(ContractTable::get_by_index(i)->ticker);
   }
 
   const std::string& trader_cmd_topic() const { return trader_cmd_topic_; }
   const std::string& rpnl_key() const { return realized_pnl_key_; }
   const std::string& fpnl_key() const { return float_pnl_key_; }
   const std::string& pos_key_prefix() const { return pos_key_prefix_; }
+  const std::string& quote_shm_name() const { return quote_shm_name_; }
+  const std::string& trader_cmd_shm_name() const {
+    return trader_cmd_shm_name_;
+  }
+  const std::string& pos_shm_name() const { return pos_shm_name_; }
+  const std::string& quote_table_shm_name() const {
+    return quote_table_shm_name_;
+  }
+  const std::string& metrics_shm_name() const { return metrics_shm_name_; }
 
   std::string pos_key(const std::string& ticker) const {
     return fmt::format("{}{}", pos_key_prefix_, ticker);
   }
 
+  /*
+   * 以ticker_index查询的版本不会分配内存，但要求在set_account之前已调用
+   * ContractTable::init，且ticker_index有效
+   */
+  const std::string& pos_key(uint32_t ticker_index) const {
+    return pos_keys_[ticker_index];
+  }
+
   std::string quote_key(const std::string& ticker) const {
     return fmt::format("quote-{}", ticker);
   }
 
+  const std::string& quote_key(uint32_t ticker_index) const {
+    return ContractTable::quote_topic(ticker_index);
+  }
+
+  std::string order_rsp_shm_name(const std::string& strategy_id) const {
+    return fmt::format("/ft-rsp-{}-{}", account_abbreviation_, strategy_id);
+  }
+
  private:
   uint64_t account_id_;
   std::string account_abbreviation_;
@@ -126,6 +256,12 @@ class ProtocolQueryCenter {
   std::string realized_pnl_key_;
   std::string float_pnl_key_;
   std::string pos_key_prefix_;
+  std::string quote_shm_name_;
+  std::string trader_cmd_shm_name_;
+  std::string pos_shm_name_;
+  std::string quote_table_shm_name_;
+  std::string metrics_shm_name_;
+  std::vector<std::string> pos_keys_;
 };
 
 }  // namespace ft
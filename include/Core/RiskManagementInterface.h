@@ -4,6 +4,7 @@
 #define FT_INCLUDE_CORE_RISKMANAGEMENTINTERFACE_H_
 
 #include "Core/Protocol.h"
+#include "Core/TickData.h"
 
 namespace ft {
 
@@ -20,6 +21,11 @@ class RiskManagementInterface {
                                double traded_price) {}
 
   virtual void on_order_completed(uint64_t engine_order_id, int error_code) {}
+
+  /*
+   * 收到行情时回调，在网关的行情回调线程中调用，与其他回调不在同一线程
+   */
+  virtual void on_tick(const TickData* tick) {}
 };
 
 }  // namespace ft
@@ -0,0 +1,136 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_BROADCASTRING_H_
+#define FT_INCLUDE_IPC_BROADCASTRING_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ft {
+
+/*
+ * 单写多读的广播环形队列，可直接放在共享内存中使用
+ *
+ * 写者从不等待读者，读者各自维护自己的读取位置。每个槽位带有一个序号，
+ * 读者通过序号判断数据是否已写完、是否已被写者覆盖(读者太慢)
+ *
+ * 序号规则：第i条消息(从0开始)写入时槽位序号为2i+1，写完后为2i+2
+ */
+template <class T, std::size_t N>
+class BroadcastRing {
+  static_assert((N & (N - 1)) == 0, "N must be power of 2");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "T must be trivially copyable");
+
+ public:
+  enum ReadResult { READ_OK = 0, READ_EMPTY, READ_OVERRUN };
+
+  static constexpr uint32_t kMagic = 0x62726e67;
+
+  void init() {
+    write_seq_.store(0, std::memory_order_relaxed);
+    for (auto& slot : slots_) slot.seq.store(0, std::memory_order_relaxed);
+    magic_.store(kMagic, std::memory_order_release);
+  }
+
+  bool is_ready() const {
+    return magic_.load(std::memory_order_acquire) == kMagic;
+  }
+
+  /*
+   * 只能有一个写者
+   */
+  void push(const T& data) {
+    uint64_t seq = write_seq_.load(std::memory_order_relaxed);
+    auto& slot = slots_[seq & (N - 1)];
+
+    slot.seq.store(2 * seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&slot.data, &data, sizeof(T));
+    slot.seq.store(2 * seq + 2, std::memory_order_release);
+
+    write_seq_.store(seq + 1, std::memory_order_release);
+  }
+
+  /*
+   * 下一条将要写入的消息的序号
+   */
+  uint64_t tail() const { return write_seq_.load(std::memory_order_acquire); }
+
+  ReadResult read(uint64_t seq, T* data) const {
+    if (seq >= tail()) return READ_EMPTY;
+
+    const auto& slot = slots_[seq & (N - 1)];
+    uint64_t expected = 2 * seq + 2;
+    if (slot.seq.load(std::memory_order_acquire) != expected)
+      return READ_OVERRUN;
+
+    memcpy(data, &slot.data, sizeof(T));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != expected)
+      return READ_OVERRUN;
+
+    return READ_OK;
+  }
+
+  static constexpr std::size_t capacity() { return N; }
+
+ private:
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> seq;
+    T data;
+  };
+
+  std::atomic<uint32_t> magic_;
+  alignas(64) std::atomic<uint64_t> write_seq_;
+  Slot slots_[N];
+};
+
+/*
+ * BroadcastRing的读者，从创建时队列的尾部开始读取
+ */
+template <class T, std::size_t N>
+class BroadcastRingReader {
+ public:
+  using Ring = BroadcastRing<T, N>;
+
+  void attach(const Ring* ring) {
+    ring_ = ring;
+    cursor_ = ring->tail();
+  }
+
+  /*
+   * 读取下一条消息，没有新消息时返回false。
+   * 如果读者太慢而被写者覆盖，则跳到队列尾部继续读，丢失的条数累加到lost()
+   */
+  bool next(T* data) {
+    for (;;) {
+      auto res = ring_->read(cursor_, data);
+      if (res == Ring::READ_OK) {
+        ++cursor_;
+        return true;
+      }
+
+      if (res == Ring::READ_EMPTY) return false;
+
+      uint64_t tail = ring_->tail();
+      lost_ += tail - cursor_;
+      cursor_ = tail;
+    }
+  }
+
+  uint64_t cursor() const { return cursor_; }
+
+  uint64_t lost() const { return lost_; }
+
+ private:
+  const Ring* ring_ = nullptr;
+  uint64_t cursor_ = 0;
+  uint64_t lost_ = 0;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_BROADCASTRING_H_
@@ -0,0 +1,36 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_FUTEX_H_
+#define FT_INCLUDE_IPC_FUTEX_H_
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+namespace ft {
+
+/*
+ * futex的简单封装。没有使用FUTEX_PRIVATE_FLAG，因为futex字可能位于
+ * 多个进程共享的内存中
+ */
+inline void futex_wait(std::atomic<uint32_t>* addr, uint32_t expected,
+                       uint64_t timeout_ms) {
+  timespec ts;
+  ts.tv_sec = timeout_ms / 1000;
+  ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, expected,
+          &ts, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<uint32_t>* addr, int count = 1) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, count,
+          nullptr, nullptr, 0);
+}
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_FUTEX_H_
@@ -0,0 +1,190 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_MPSCQUEUE_H_
+#define FT_INCLUDE_IPC_MPSCQUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include "IPC/Futex.h"
+
+namespace ft {
+
+/*
+ * 多写单读的有界无锁队列，槽位大小固定，可直接放在共享内存中使用
+ *
+ * 每个槽位有一个序号：序号等于写入位置时槽位空闲，等于写入位置+1时
+ * 槽位中有数据等待读取，读者读取后把序号推进N，留给下一轮的写者
+ *
+ * 读者可以忙等，也可以通过wait()在futex上休眠，写者写入后如发现读者
+ * 在休眠则将其唤醒
+ */
+template <class T, std::size_t N>
+class MpscQueue {
+  static_assert((N & (N - 1)) == 0, "N must be power of 2");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "T must be trivially copyable");
+
+ public:
+  static constexpr uint32_t kMagic = 0x6d707363;
+
+  /*
+   * 槽位数据的大小和槽位数，T的定义或N变化时与共享内存中旧的队列不一致，
+   * is_ready返回false
+   */
+  static constexpr uint64_t layout() {
+    return (static_cast<uint64_t>(sizeof(T)) << 32) | N;
+  }
+
+  /*
+   * 只在创建队列时调用。重新初始化时不能有写者正在写入，要丢弃已有的
+   * 数据应由读者逐条读出
+   */
+  void init() {
+    magic_.store(0, std::memory_order_release);
+    layout_ = layout();
+    for (std::size_t i = 0; i < N; ++i)
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    head_.store(0, std::memory_order_relaxed);
+    sleeping_.store(0, std::memory_order_relaxed);
+    futex_seq_.store(0, std::memory_order_relaxed);
+    magic_.store(kMagic, std::memory_order_release);
+  }
+
+  bool is_ready() const {
+    return magic_.load(std::memory_order_acquire) == kMagic &&
+           layout_ == layout();
+  }
+
+  /*
+   * 队列满时返回false
+   */
+  bool try_push(const T& data) {
+    Cell* cell;
+    uint64_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &cells_[pos & (N - 1)];
+      uint64_t seq = cell->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->data = data;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    notify();
+    return true;
+  }
+
+  /*
+   * 把n条数据写入连续的n个槽位，读者会按顺序读到这n条数据，中间不会
+   * 插入其他写者的数据。剩余空间不足时返回false
+   */
+  bool try_push_n(const T* data, std::size_t n) {
+    if (n == 0 || n > N) return false;
+
+    uint64_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      // 读者按顺序释放槽位，最后一个槽位空闲说明前面的槽位也都空闲
+      uint64_t last = pos + n - 1;
+      uint64_t seq = cells_[last & (N - 1)].seq.load(std::memory_order_acquire);
+      auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(last);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + n,
+                                        std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+      auto& cell = cells_[(pos + i) & (N - 1)];
+      cell.data = data[i];
+      cell.seq.store(pos + i + 1, std::memory_order_release);
+    }
+    notify();
+    return true;
+  }
+
+  /*
+   * 只能有一个读者
+   */
+  bool try_pop(T* data) {
+    uint64_t pos = head_.load(std::memory_order_relaxed);
+    auto& cell = cells_[pos & (N - 1)];
+    if (cell.seq.load(std::memory_order_acquire) != pos + 1) return false;
+
+    *data = cell.data;
+    cell.seq.store(pos + N, std::memory_order_release);
+    head_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool empty() const {
+    uint64_t pos = head_.load(std::memory_order_relaxed);
+    return cells_[pos & (N - 1)].seq.load(std::memory_order_acquire) != pos + 1;
+  }
+
+  /*
+   * 读者在队列为空时休眠，直到有新数据写入或超时
+   */
+  void wait(uint64_t timeout_ms) {
+    uint32_t seq = futex_seq_.load(std::memory_order_acquire);
+    sleeping_.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (empty()) futex_wait(&futex_seq_, seq, timeout_ms);
+
+    sleeping_.store(0, std::memory_order_relaxed);
+  }
+
+  /*
+   * 已写入或正在写入但还未读取的数据量，只是近似值，用于监控
+   */
+  std::size_t size() const {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+
+  static constexpr std::size_t capacity() { return N; }
+
+ private:
+  void notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed)) {
+      futex_seq_.fetch_add(1, std::memory_order_release);
+      futex_wake(&futex_seq_);
+    }
+  }
+
+ private:
+  struct alignas(64) Cell {
+    std::atomic<uint64_t> seq;
+    T data;
+  };
+
+  std::atomic<uint32_t> magic_;
+  uint64_t layout_;
+  alignas(64) std::atomic<uint64_t> tail_;
+  alignas(64) std::atomic<uint64_t> head_;
+  alignas(64) std::atomic<uint32_t> sleeping_;
+  std::atomic<uint32_t> futex_seq_;
+  Cell cells_[N];
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_MPSCQUEUE_H_
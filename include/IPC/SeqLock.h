@@ -0,0 +1,72 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_SEQLOCK_H_
+#define FT_INCLUDE_IPC_SEQLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "Utils/Misc.h"
+
+namespace ft {
+
+/*
+ * 由顺序锁保护的单条记录，可直接放在共享内存中使用
+ *
+ * 只能有一个写者，写者从不等待。写入前序号变为奇数，写完后变为偶数，
+ * 读者读取前后序号不变且为偶数时说明读到的是一份完整的快照，否则重试
+ *
+ * 每条记录独占缓存行，相邻记录的读写互不干扰
+ */
+template <class T>
+class alignas(64) SeqLocked {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "T must be trivially copyable");
+
+ public:
+  void init() {
+    data_ = T{};
+    seq_.store(0, std::memory_order_release);
+  }
+
+  void store(const T& data) {
+    uint64_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&data_, &data, sizeof(T));
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  /*
+   * 读到完整快照时返回true，写者正在写入时返回false
+   */
+  bool try_load(T* data) const {
+    uint64_t seq = seq_.load(std::memory_order_acquire);
+    if (seq & 1) return false;
+
+    memcpy(data, &data_, sizeof(T));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return seq_.load(std::memory_order_relaxed) == seq;
+  }
+
+  void load(T* data) const {
+    while (!try_load(data)) cpu_relax();
+  }
+
+  /*
+   * 记录被写入的次数
+   */
+  uint64_t version() const {
+    return seq_.load(std::memory_order_acquire) / 2;
+  }
+
+ private:
+  std::atomic<uint64_t> seq_;
+  T data_;
+};
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_SEQLOCK_H_
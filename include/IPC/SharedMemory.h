@@ -0,0 +1,143 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_INCLUDE_IPC_SHAREDMEMORY_H_
+#define FT_INCLUDE_IPC_SHAREDMEMORY_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace ft {
+
+/*
+ * POSIX共享内存的简单封装，映射的内存位于/dev/shm下
+ *
+ * 同一块共享内存可能由交易引擎或策略中的任意一方先创建，所以通常使用
+ * open_or_create。只有创建者需要初始化内存中的数据结构，其他进程通过
+ * created()判断自己是否是创建者
+ */
+class SharedMemory {
+ public:
+  SharedMemory() = default;
+
+  SharedMemory(const SharedMemory&) = delete;
+  SharedMemory& operator=(const SharedMemory&) = delete;
+
+  ~SharedMemory() { close(); }
+
+  /*
+   * 打开已存在的共享内存，不存在或大小不足时返回false
+   */
+  bool open(const std::string& name, std::size_t size) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0666);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < size) {
+      ::close(fd);
+      return false;
+    }
+
+    return map(fd, size, false);
+  }
+
+  /*
+   * 共享内存不存在时创建，存在时打开
+   */
+  bool open_or_create(const std::string& name, std::size_t size) {
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd >= 0) {
+      fchmod(fd, 0666);  // 不受umask影响，使其他用户的策略也能打开
+      if (ftruncate(fd, size) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+      }
+      return map(fd, size, true);
+    }
+
+    if (errno != EEXIST) return false;
+
+    // 创建者可能还没来得及ftruncate，稍等片刻
+    for (int i = 0; i < 1000; ++i) {
+      if (open(name, size)) return true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return false;
+  }
+
+  void close() {
+    if (addr_) {
+      munmap(addr_, size_);
+      addr_ = nullptr;
+      size_ = 0;
+      created_ = false;
+    }
+  }
+
+  static void unlink(const std::string& name) { shm_unlink(name.c_str()); }
+
+  void* data() const { return addr_; }
+
+  std::size_t size() const { return size_; }
+
+  bool created() const { return created_; }
+
+  bool is_open() const { return addr_ != nullptr; }
+
+ private:
+  bool map(int fd, std::size_t size, bool created) {
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return false;
+
+    addr_ = addr;
+    size_ = size;
+    created_ = created;
+    return true;
+  }
+
+ private:
+  void* addr_ = nullptr;
+  std::size_t size_ = 0;
+  bool created_ = false;
+};
+
+/*
+ * 把共享内存映射为T类型的对象。T需要提供init()和is_ready()：
+ * 创建者负责调用init()，其他进程等待创建者初始化完成
+ */
+template <class T>
+T* attach_shm_object(SharedMemory* shm, const std::string& name) {
+  if (!shm->open_or_create(name, sizeof(T))) return nullptr;
+
+  auto* obj = reinterpret_cast<T*>(shm->data());
+  if (shm->created()) {
+    obj->init();
+    return obj;
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    if (obj->is_ready()) return obj;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  shm->close();
+  return nullptr;
+}
+
+}  // namespace ft
+
+#endif  // FT_INCLUDE_IPC_SHAREDMEMORY_H_
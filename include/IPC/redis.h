@@ -5,11 +5,11 @@
 
 #include <async.h>
 #include <hiredis.h>
+#include <poll.h>
 #include <spdlog/spdlog.h>
 
 #include <cassert>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <vector>
 
@@ -36,6 +36,8 @@ class RedisSession {
     assert(ctx_ && ctx_->err == 0);
   }
 
+  int fd() const { return ctx_->fd; }
+
   void set_timeout(uint64_t timeout_ms) {
     timeval tv;
     tv.tv_sec = timeout_ms / 1000;
@@ -63,6 +65,46 @@ class RedisSession {
     freeReplyObject(reply);
   }
 
+  /*
+   * 只把set命令写入输出缓冲区而不等待回复，多条命令在flush_pipeline时
+   * 一次性发出，只需要一次往返
+   */
+  void append_set(const std::string& key, const void* p, size_t size) {
+    const char* argv[3];
+    size_t argvlen[3];
+
+    argv[0] = "set";
+    argvlen[0] = 3;
+
+    argv[1] = key.c_str();
+    argvlen[1] = key.length();
+
+    argv[2] = reinterpret_cast<const char*>(p);
+    argvlen[2] = size;
+
+    // 写入失败的命令不会有回复，不能计入pending_replies_
+    if (redisAppendCommandArgv(ctx_, 3, argv, argvlen) != REDIS_OK) {
+      spdlog::error("[RedisSession::append_set] {}", ctx_->errstr);
+      return;
+    }
+    ++pending_replies_;
+  }
+
+  /*
+   * 发出所有append的命令并读取它们的回复
+   */
+  void flush_pipeline() {
+    for (; pending_replies_ > 0; --pending_replies_) {
+      redisReply* reply;
+      if (redisGetReply(ctx_, reinterpret_cast<void**>(&reply)) != REDIS_OK) {
+        spdlog::error("[RedisSession::flush_pipeline] {}", ctx_->errstr);
+        pending_replies_ = 0;
+        return;
+      }
+      freeReplyObject(reply);
+    }
+  }
+
   RedisReply get(const std::string& key) const {
     const char* argv[2];
     size_t argvlen[2];
@@ -113,13 +155,20 @@ class RedisSession {
   void subscribe(const std::vector<std::string>& topics) {
     if (topics.empty()) return;
 
-    std::stringstream ss;
-    std::string args;
-    for (const auto& topic : topics) ss << topic << " ";
-    ss >> args;
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+
+    argv.emplace_back("subscribe");
+    argvlen.emplace_back(9);
+    for (const auto& topic : topics) {
+      argv.emplace_back(topic.c_str());
+      argvlen.emplace_back(topic.length());
+    }
 
-    auto* reply = reinterpret_cast<redisReply*>(
-        redisCommand(ctx_, "subscribe %s", args.c_str()));
+    // 每个topic都会有一个订阅确认，这里只读取了第一个，
+    // 其余的由get_sub_reply的调用者过滤
+    auto* reply = reinterpret_cast<redisReply*>(redisCommandArgv(
+        ctx_, argv.size(), argv.data(), argvlen.data()));
     freeReplyObject(reply);
   }
 
@@ -130,6 +179,52 @@ class RedisSession {
     return nullptr;
   }
 
+  /*
+   * 非阻塞版本的get_sub_reply，没有已到达的完整回复时立即返回nullptr
+   */
+  RedisReply try_get_sub_reply() {
+    redisReply* reply = nullptr;
+    if (redisGetReplyFromReader(ctx_, reinterpret_cast<void**>(&reply)) !=
+        REDIS_OK)
+      return nullptr;
+
+    if (!reply) {
+      pollfd pfd{ctx_->fd, POLLIN, 0};
+      if (poll(&pfd, 1, 0) <= 0 || redisBufferRead(ctx_) != REDIS_OK)
+        return nullptr;
+
+      if (redisGetReplyFromReader(ctx_, reinterpret_cast<void**>(&reply)) !=
+              REDIS_OK ||
+          !reply)
+        return nullptr;
+    }
+
+    return RedisReply(reply, RedisReplyDestructor());
+  }
+
+  /*
+   * 与append_set一样，需要调用flush_pipeline才会真正发出
+   */
+  void append_publish(const std::string& topic, const void* p, size_t size) {
+    const char* argv[3];
+    size_t argvlen[3];
+
+    argv[0] = "publish";
+    argvlen[0] = 7;
+
+    argv[1] = topic.c_str();
+    argvlen[1] = topic.length();
+
+    argv[2] = reinterpret_cast<const char*>(p);
+    argvlen[2] = size;
+
+    if (redisAppendCommandArgv(ctx_, 3, argv, argvlen) != REDIS_OK) {
+      spdlog::error("[RedisSession::append_publish] {}", ctx_->errstr);
+      return;
+    }
+    ++pending_replies_;
+  }
+
   void publish(const std::string& topic, const void* p, size_t size) {
     const char* argv[3];
     size_t argvlen[3];
@@ -151,6 +246,7 @@ class RedisSession {
 
  private:
   redisContext* ctx_ = nullptr;
+  int pending_replies_ = 0;
 };
 
 class AsyncRedisSession {
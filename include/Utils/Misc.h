@@ -3,6 +3,23 @@
 #ifndef FT_INCLUDE_UTILS_MISC_H_
 #define FT_INCLUDE_UTILS_MISC_H_
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 #define UNUSED(x) ((void)(x))
 
+namespace ft {
+
+/*
+ * 忙等时调用，降低自旋对同一物理核上另一个超线程的影响
+ */
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#endif
+}
+
+}  // namespace ft
+
 #endif  // FT_INCLUDE_UTILS_MISC_H_
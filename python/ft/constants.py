@@ -16,6 +16,11 @@ NEW_ORDER = 1
 CANCEL_ORDER = 2
 CANCEL_TICKER = 3
 CANCEL_ALL = 4
+QUERY_ORDERS = 5
+CANCEL_STRATEGY = 6
+NEW_ORDER_BATCH = 7
+REPLACE_ORDER = 8
+MAX_BATCH_ORDERS = 256
 
 CMD_MAGIC = 0x1709394
 CMD_TOPIC = 'trader_cmd'
@@ -12,7 +12,7 @@ def gen_order_req(ticker, direction, offset, volume, price,
     if not contract:
         return None
 
-    req = struct.pack('<II16sIIIIIid', constants.CMD_MAGIC, constants.NEW_ORDER,
+    req = struct.pack('<II16sIIIIIid8x', constants.CMD_MAGIC, constants.NEW_ORDER,
                       strategy_id.encode(encoding='utf-8'), user_order_id,
                       contract.ticker_index, direction, offset, order_type,
                       volume, price)
@@ -34,5 +34,37 @@ class OrderSender(object):
             return True
         return False
 
+    def send_order_batch(self, orders):
+        """
+        orders: [(ticker, direction, offset, order_type, volume, price,
+                  user_order_id), ...]
+        """
+        if not orders or len(orders) > constants.MAX_BATCH_ORDERS:
+            return False
+
+        req = struct.pack('<II16sI28x8x', constants.CMD_MAGIC,
+                          constants.NEW_ORDER_BATCH,
+                          self.strategy_id.encode(encoding='utf-8'),
+                          len(orders))
+        for (ticker, direction, offset, order_type, volume, price,
+             user_order_id) in orders:
+            contract = contract_table.ct.get_by_ticker(ticker)
+            if not contract:
+                return False
+            req += struct.pack('<IIIIIid', user_order_id,
+                               contract.ticker_index, direction, offset,
+                               order_type, volume, price)
+
+        self.redis.publish(constants.CMD_TOPIC, req)
+        return True
+
     def cancel_order(self, order_id):
         pass
+
+    def cancel_strategy(self, strategy_id=None):
+        if strategy_id is None:
+            strategy_id = self.strategy_id
+        req = struct.pack('<II16s32x8x', constants.CMD_MAGIC,
+                          constants.CANCEL_STRATEGY,
+                          strategy_id.encode(encoding='utf-8'))
+        self.redis.publish(constants.CMD_TOPIC, req)
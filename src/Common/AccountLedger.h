@@ -0,0 +1,153 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_COMMON_ACCOUNTLEDGER_H_
+#define FT_SRC_COMMON_ACCOUNTLEDGER_H_
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "Common/PositionTable.h"
+#include "Core/Account.h"
+#include "Core/Constants.h"
+#include "Core/Contract.h"
+#include "Core/Position.h"
+#include "IPC/SharedMemory.h"
+
+namespace ft {
+
+/*
+ * 账户资金台账
+ *
+ * 冻结资金、占用保证金的计算只在这里进行，交易引擎在报单、撤单、拒单和
+ * 成交时调用对应的函数增量更新，风控规则通过available()以O(1)查询可用
+ * 资金。每次变化后把账户快照写入共享内存的仓位表，策略可以直接读取
+ *
+ * 市价单没有报单价，按交易引擎通过mark_price记录的最新价估算保证金
+ *
+ * 除mark_price外只能在交易引擎线程中更新
+ */
+class AccountLedger {
+ public:
+  /*
+   * 打开仓位表并发布当前的账户，须在PositionManager::init之后调用
+   */
+  void init(const std::string& pos_shm_name) {
+    pos_table_ = attach_shm_object<PositionTable>(&pos_shm_, pos_shm_name);
+    if (!pos_table_)
+      spdlog::warn("[AccountLedger::init] Failed to open {}", pos_shm_name);
+    publish();
+  }
+
+  /*
+   * 柜台查询到的账户，覆盖之前的所有数据
+   */
+  void set_account(const Account& account) {
+    account_ = account;
+    update();
+  }
+
+  static double margin_rate(const Contract* contract, uint32_t direction) {
+    return direction == Direction::BUY ? contract->long_margin_rate
+                                       : contract->short_margin_rate;
+  }
+
+  /*
+   * 以price开volume手所需的保证金
+   */
+  static double margin_of(const Contract* contract, uint32_t direction,
+                          int volume, double price) {
+    return contract->size * volume * price * margin_rate(contract, direction);
+  }
+
+  /*
+   * 记录合约的最新价，可以在行情回调线程中调用
+   */
+  void mark_price(uint32_t ticker_index, double last_price) {
+    if (PositionTable::is_valid_index(ticker_index) && last_price > 0)
+      last_prices_[ticker_index].store(last_price, std::memory_order_relaxed);
+  }
+
+  /*
+   * 估算订单保证金所用的价格，限价单为报单价，市价单为最新价，还没有
+   * 收到过该合约的行情时返回0
+   */
+  double margin_price(uint32_t ticker_index, uint32_t type,
+                      double price) const {
+    if (type != OrderType::MARKET && type != OrderType::BEST) return price;
+    if (!PositionTable::is_valid_index(ticker_index)) return 0;
+    return last_prices_[ticker_index].load(std::memory_order_relaxed);
+  }
+
+  /*
+   * 查询到的初始仓位按持仓成本占用保证金
+   */
+  void add_position(const Contract* contract, const Position& pos) {
+    account_.margin += margin_of(contract, Direction::BUY,
+                                 pos.long_pos.holdings,
+                                 pos.long_pos.cost_price);
+    account_.margin += margin_of(contract, Direction::SELL,
+                                 pos.short_pos.holdings,
+                                 pos.short_pos.cost_price);
+    update();
+  }
+
+  /*
+   * 冻结(volume > 0)或解冻(volume < 0)开仓单占用的资金，平仓单不占用。
+   * price为margin_price的返回值，同一订单的冻结和解冻须使用同一个价格
+   */
+  void freeze(const Contract* contract, uint32_t direction, uint32_t offset,
+              int volume, double price) {
+    if (!is_offset_open(offset)) return;
+    account_.frozen += margin_of(contract, direction, volume, price);
+    update();
+  }
+
+  /*
+   * 开仓成交时按冻结时的价格(frozen_price)解冻，按成交价占用保证金；平仓
+   * 成交时按成交价释放保证金
+   */
+  void on_traded(const Contract* contract, uint32_t direction,
+                 uint32_t offset, int traded, double frozen_price,
+                 double traded_price) {
+    if (is_offset_open(offset)) {
+      account_.frozen -= margin_of(contract, direction, traded, frozen_price);
+      account_.margin += margin_of(contract, direction, traded, traded_price);
+    } else if (is_offset_close(offset)) {
+      account_.margin -= margin_of(contract, direction, traded, traded_price);
+      if (account_.margin < 0) account_.margin = 0;
+    } else {
+      return;
+    }
+    update();
+  }
+
+  double available() const { return available_; }
+
+  const Account& account() const { return account_; }
+
+ private:
+  void update() {
+    available_ = account_.balance - account_.frozen - account_.margin;
+    publish();
+  }
+
+  void publish() {
+    if (pos_table_) pos_table_->store_account(account_);
+  }
+
+ private:
+  Account account_{};
+  double available_ = 0;
+  std::unique_ptr<std::atomic<double>[]> last_prices_ =
+      std::make_unique<std::atomic<double>[]>(PositionTable::kMaxTickers);
+
+  SharedMemory pos_shm_;
+  PositionTable* pos_table_ = nullptr;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_COMMON_ACCOUNTLEDGER_H_
@@ -0,0 +1,199 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_COMMON_LATENCYSTATS_H_
+#define FT_SRC_COMMON_LATENCYSTATS_H_
+
+#include <signal.h>
+#include <spdlog/spdlog.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace ft {
+
+/*
+ * 单调时钟，单位为ns。引擎和策略在同一台机器上，可以直接比较双方记录的
+ * 时间；不使用rdtsc是因为它需要按CPU频率校准，且不同核心间不保证同步
+ */
+inline uint64_t monotonic_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * 对数-线性分桶的延迟直方图(类似HdrHistogram)
+ *
+ * 小于16ns的值每ns一个桶，之后每个2的幂区间等分为16个桶，相对误差不超过
+ * 1/16。桶的数量固定，记录一个样本只需要几条整数指令，不分配内存
+ */
+class LatencyHistogram {
+ public:
+  static constexpr uint32_t kSubBits = 4;
+  static constexpr uint32_t kSubCount = 1 << kSubBits;
+  static constexpr uint32_t kBucketCount = (64 - kSubBits + 1) * kSubCount;
+
+  void record(uint64_t value) {
+    ++buckets_[bucket_of(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  void reset() {
+    memset(buckets_, 0, sizeof(buckets_));
+    count_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+  }
+
+  uint64_t count() const { return count_; }
+
+  uint64_t min() const { return count_ > 0 ? min_ : 0; }
+
+  uint64_t max() const { return max_; }
+
+  /*
+   * p为0~1之间的分位，返回所在桶的下界，没有样本时返回0
+   */
+  uint64_t percentile(double p) const {
+    if (count_ == 0) return 0;
+
+    uint64_t target = static_cast<uint64_t>(p * count_ + 0.5);
+    target = std::max<uint64_t>(target, 1);
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < kBucketCount; ++i) {
+      sum += buckets_[i];
+      if (sum >= target) return std::clamp(lower_bound(i), min_, max_);
+    }
+    return max_;
+  }
+
+ private:
+  static uint32_t bucket_of(uint64_t value) {
+    if (value < kSubCount) return value;
+    uint32_t exp = 63 - __builtin_clzll(value);
+    uint32_t sub = (value >> (exp - kSubBits)) & (kSubCount - 1);
+    return (exp - kSubBits + 1) * kSubCount + sub;
+  }
+
+  static uint64_t lower_bound(uint32_t bucket) {
+    if (bucket < kSubCount) return bucket;
+    uint32_t exp = bucket / kSubCount + kSubBits - 1;
+    uint64_t sub = bucket % kSubCount;
+    return (kSubCount + sub) << (exp - kSubBits);
+  }
+
+ private:
+  uint64_t buckets_[kBucketCount]{};
+  uint64_t count_ = 0;
+  uint64_t min_ = UINT64_MAX;
+  uint64_t max_ = 0;
+};
+
+/*
+ * 订单链路上的各个阶段
+ *
+ * LAT_CMD_TRANSPORT: 策略发出指令 -> 引擎收到指令
+ * LAT_INBOUND_QUEUE: 事件进入引擎队列 -> 引擎线程开始处理
+ * LAT_RISK_CHECK: 引擎开始处理 -> 风控检查完毕
+ * LAT_GATEWAY_SEND: 风控检查完毕 -> 网关发送函数返回
+ * LAT_STRATEGY_TO_GATEWAY: 策略发出指令 -> 网关发送函数返回
+ * LAT_EXCHANGE_ACK: 网关发出订单 -> 收到柜台的委托回报
+ * LAT_EXCHANGE_FILL: 网关发出订单 -> 收到成交回报
+ * LAT_RSP_TRANSPORT: 引擎发出回报 -> 策略收到回报
+ * LAT_ACK_ROUND_TRIP: 策略发出指令 -> 策略收到委托回报
+ * LAT_FILL_ROUND_TRIP: 策略发出指令 -> 策略收到成交回报
+ */
+enum LatencyStage : uint32_t {
+  LAT_CMD_TRANSPORT = 0,
+  LAT_INBOUND_QUEUE,
+  LAT_RISK_CHECK,
+  LAT_GATEWAY_SEND,
+  LAT_STRATEGY_TO_GATEWAY,
+  LAT_EXCHANGE_ACK,
+  LAT_EXCHANGE_FILL,
+  LAT_RSP_TRANSPORT,
+  LAT_ACK_ROUND_TRIP,
+  LAT_FILL_ROUND_TRIP,
+  LAT_STAGE_COUNT
+};
+
+inline const char* latency_stage_str(uint32_t stage) {
+  static const char* names[LAT_STAGE_COUNT] = {
+      "cmd transport",   "inbound queue",     "risk check",
+      "gateway send",    "strategy->gateway", "exchange ack",
+      "exchange fill",   "rsp transport",     "ack round trip",
+      "fill round trip",
+  };
+  return stage < LAT_STAGE_COUNT ? names[stage] : "unknown";
+}
+
+/*
+ * 收到SIGUSR1时置位，由引擎和策略的事件循环检查后输出延迟统计
+ */
+inline std::atomic<bool> latency_dump_requested{false};
+
+inline void install_latency_dump_handler() {
+  signal(SIGUSR1, [](int) {
+    latency_dump_requested.store(true, std::memory_order_relaxed);
+  });
+}
+
+/*
+ * 按阶段统计延迟，未启用时record不做任何事。只能在一个线程中使用
+ */
+class LatencyTracer {
+ public:
+  void set_enabled(bool enabled) { enabled_ = enabled; }
+
+  bool enabled() const { return enabled_; }
+
+  /*
+   * 返回当前时间，未启用时返回0，0在record中表示没有时间戳
+   */
+  uint64_t now() const { return enabled_ ? monotonic_ns() : 0; }
+
+  void record(LatencyStage stage, uint64_t begin_ns, uint64_t end_ns) {
+    if (!enabled_ || begin_ns == 0 || end_ns < begin_ns) return;
+    hists_[stage].record(end_ns - begin_ns);
+  }
+
+  /*
+   * 收到过SIGUSR1时输出统计并清零，在事件循环中调用
+   */
+  void dump_if_requested(const char* title) {
+    if (!latency_dump_requested.load(std::memory_order_relaxed)) return;
+    latency_dump_requested.store(false, std::memory_order_relaxed);
+    dump(title);
+    for (auto& hist : hists_) hist.reset();
+  }
+
+  void dump(const char* title) const {
+    spdlog::info("[{}] latency(us)        count      min      p50      p90"
+                 "      p99    p99.9      max",
+                 title);
+    for (uint32_t i = 0; i < LAT_STAGE_COUNT; ++i) {
+      const auto& h = hists_[i];
+      if (h.count() == 0) continue;
+      spdlog::info(
+          "[{}] {:<18} {:>8} {:>8.1f} {:>8.1f} {:>8.1f} {:>8.1f} {:>8.1f} "
+          "{:>8.1f}",
+          title, latency_stage_str(i), h.count(), h.min() / 1e3,
+          h.percentile(0.5) / 1e3, h.percentile(0.9) / 1e3,
+          h.percentile(0.99) / 1e3, h.percentile(0.999) / 1e3,
+          h.max() / 1e3);
+    }
+  }
+
+ private:
+  bool enabled_ = false;
+  LatencyHistogram hists_[LAT_STAGE_COUNT];
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_COMMON_LATENCYSTATS_H_
@@ -0,0 +1,145 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_COMMON_METRICS_H_
+#define FT_SRC_COMMON_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "IPC/SharedMemory.h"
+
+namespace ft {
+
+/*
+ * 累计计数，ft-stat按采样间隔计算速率
+ */
+enum MetricCounter : uint32_t {
+  MC_CMD_RECEIVED = 0,   // 收到的策略指令
+  MC_ORDER_SENT,         // 发送成功的订单
+  MC_ORDER_SEND_FAILED,  // 网关发送失败的订单
+  MC_ORDER_ACCEPTED,
+  MC_ORDER_REJECTED,
+  MC_ORDER_TRADED,       // 成交回报笔数
+  MC_ORDER_CANCELED,
+  MC_CANCEL_REJECTED,
+  MC_RISK_REJECTED,      // 风控拒绝的订单，按规则的细分见risk_rejects
+  MC_GATEWAY_TICK,       // 网关收到的行情
+  MC_GATEWAY_ORDER_RSP,  // 网关收到的订单及成交回报
+  MC_GATEWAY_ERROR,      // 网关收到的错误回报
+  MC_PUBLISH_FAILED,     // 发布失败的回报及异步发布时丢弃的行情
+  MC_LOG_DROPPED,        // 事件日志的环形缓冲区写满时丢弃的事件
+  MC_COUNT
+};
+
+/*
+ * 瞬时值
+ */
+enum MetricGauge : uint32_t {
+  MG_LIVE_ORDERS = 0,      // 在途订单数
+  MG_EVENT_QUEUE_DEPTH,    // 引擎入站队列中等待处理的事件数
+  MG_PUBLISH_QUEUE_DEPTH,  // 异步发布队列中等待发布的消息数
+  MG_COUNT
+};
+
+/*
+ * 共享内存中的引擎运行指标，引擎、风控和网关以relaxed原子操作更新，
+ * ft-stat等工具只读。每个指标独占一个缓存行，不同线程更新不同指标时
+ * 不会互相干扰
+ */
+class MetricsPage {
+ public:
+  static constexpr uint32_t kMagic = 0x6d747263;
+  // 按错误码统计风控拒绝，大于实际的错误码数量，新增错误码时布局不变
+  static constexpr int kMaxErrorCodes = 32;
+
+  void init() {
+    reset();
+    magic_.store(kMagic, std::memory_order_release);
+  }
+
+  bool is_ready() const {
+    return magic_.load(std::memory_order_acquire) == kMagic;
+  }
+
+  /*
+   * 交易引擎重启时清空上一次运行的数据
+   */
+  void reset() {
+    for (auto& c : counters_) c.value.store(0, std::memory_order_relaxed);
+    for (auto& g : gauges_) g.value.store(0, std::memory_order_relaxed);
+    for (auto& r : risk_rejects_) r.value.store(0, std::memory_order_relaxed);
+  }
+
+  void add(MetricCounter id, uint64_t n) {
+    counters_[id].value.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  void set(MetricGauge id, uint64_t value) {
+    gauges_[id].value.store(value, std::memory_order_relaxed);
+  }
+
+  void add_risk_reject(int error_code) {
+    if (error_code > 0 && error_code < kMaxErrorCodes)
+      risk_rejects_[error_code].value.fetch_add(1, std::memory_order_relaxed);
+    add(MC_RISK_REJECTED, 1);
+  }
+
+  uint64_t counter(MetricCounter id) const {
+    return counters_[id].value.load(std::memory_order_relaxed);
+  }
+
+  uint64_t gauge(MetricGauge id) const {
+    return gauges_[id].value.load(std::memory_order_relaxed);
+  }
+
+  uint64_t risk_rejects(int error_code) const {
+    if (error_code <= 0 || error_code >= kMaxErrorCodes) return 0;
+    return risk_rejects_[error_code].value.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct alignas(64) Slot {
+    std::atomic<uint64_t> value;
+  };
+
+  std::atomic<uint32_t> magic_;
+  Slot counters_[MC_COUNT];
+  Slot gauges_[MG_COUNT];
+  Slot risk_rejects_[kMaxErrorCodes];
+};
+
+/*
+ * 进程内更新指标的入口。open之前写入进程内的一个本地页，调用者不需要
+ * 判断指标页是否已打开
+ */
+class Metrics {
+ public:
+  /*
+   * 由交易引擎调用，打开或创建共享内存中的指标页并清空
+   */
+  static bool open(const std::string& shm_name) {
+    auto page = attach_shm_object<MetricsPage>(&shm_, shm_name);
+    if (!page) return false;
+    page->reset();
+    page_ = page;
+    return true;
+  }
+
+  static void add(MetricCounter id, uint64_t n = 1) { page_->add(id, n); }
+
+  static void set(MetricGauge id, uint64_t value) { page_->set(id, value); }
+
+  static void add_risk_reject(int error_code) {
+    page_->add_risk_reject(error_code);
+  }
+
+ private:
+  inline static MetricsPage local_page_{};
+  inline static MetricsPage* page_ = &local_page_;
+  inline static SharedMemory shm_;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_COMMON_METRICS_H_
@@ -0,0 +1,211 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_COMMON_ORDERRSPTRANSPORT_H_
+#define FT_SRC_COMMON_ORDERRSPTRANSPORT_H_
+
+#include <spdlog/spdlog.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "Common/Metrics.h"
+#include "Core/Constants.h"
+#include "Core/Protocol.h"
+#include "IPC/BroadcastRing.h"
+#include "IPC/SharedMemory.h"
+#include "IPC/redis.h"
+#include "Utils/Misc.h"
+
+namespace ft {
+
+/*
+ * 订单回报从交易引擎发往策略的通道，与行情通道一样由ipc_transport决定：
+ * redis: 以strategy id为topic publish，策略订阅不及时或处理太慢时回报
+ *        会被redis丢弃且策略无从得知
+ * shm:   每个strategy id一个共享内存环形队列，队列中的每条回报都有单调
+ *        递增的序号，策略据此发现丢失的回报(lost()增加)，然后通过
+ *        QUERY_ORDERS向引擎重新获取所有未完成订单的状态
+ */
+inline constexpr std::size_t kOrderRspRingSize = 1024;
+using OrderRspRing = BroadcastRing<OrderResponse, kOrderRspRingSize>;
+using OrderRspRingReader =
+    BroadcastRingReader<OrderResponse, kOrderRspRingSize>;
+
+class OrderRspPublisher {
+ public:
+  virtual ~OrderRspPublisher() {}
+
+  virtual void publish(const std::string& strategy_id,
+                       const OrderResponse* rsp) = 0;
+
+  /*
+   * 批量发布时，发出之前publish的所有回报
+   */
+  virtual void flush() {}
+};
+
+class OrderRspSubscriber {
+ public:
+  virtual ~OrderRspSubscriber() {}
+
+  /*
+   * 非阻塞地读取下一条回报，没有回报时返回nullptr。
+   * 返回的指针在下次调用前有效
+   */
+  virtual const OrderResponse* try_get_rsp() = 0;
+
+  /*
+   * 可用于poll/epoll等待回报到达的文件描述符，没有时返回-1
+   */
+  virtual int fd() const { return -1; }
+
+  /*
+   * 累计丢失的回报数量
+   */
+  virtual uint64_t lost() const { return 0; }
+};
+
+class RedisOrderRspPublisher : public OrderRspPublisher {
+ public:
+  explicit RedisOrderRspPublisher(bool pipelined) : pipelined_(pipelined) {}
+
+  void publish(const std::string& strategy_id,
+               const OrderResponse* rsp) override {
+    if (pipelined_)
+      redis_.append_publish(strategy_id, rsp, sizeof(*rsp));
+    else
+      redis_.publish(strategy_id, rsp, sizeof(*rsp));
+  }
+
+  void flush() override { redis_.flush_pipeline(); }
+
+ private:
+  bool pipelined_;
+  RedisSession redis_{};
+};
+
+class RedisOrderRspSubscriber : public OrderRspSubscriber {
+ public:
+  explicit RedisOrderRspSubscriber(const std::string& strategy_id) {
+    redis_.subscribe({strategy_id});
+  }
+
+  const OrderResponse* try_get_rsp() override {
+    for (;;) {
+      reply_ = redis_.try_get_sub_reply();
+      if (!reply_) return nullptr;
+
+      if (reply_->type != REDIS_REPLY_ARRAY || reply_->elements != 3 ||
+          reply_->element[2]->len != sizeof(OrderResponse))
+        continue;
+
+      return reinterpret_cast<const OrderResponse*>(reply_->element[2]->str);
+    }
+  }
+
+  int fd() const override { return redis_.fd(); }
+
+ private:
+  RedisSession redis_{};
+  RedisReply reply_{nullptr};
+};
+
+/*
+ * 引擎端为每个策略维护一个队列，在第一次向该策略发送回报时打开
+ */
+class ShmOrderRspPublisher : public OrderRspPublisher {
+ public:
+  explicit ShmOrderRspPublisher(const ProtocolQueryCenter* proto)
+      : proto_(proto) {}
+
+  void publish(const std::string& strategy_id,
+               const OrderResponse* rsp) override {
+    auto iter = channels_.find(strategy_id);
+    if (iter == channels_.end()) {
+      auto channel = std::make_unique<Channel>();
+      auto name = proto_->order_rsp_shm_name(strategy_id);
+      channel->ring = attach_shm_object<OrderRspRing>(&channel->shm, name);
+      if (!channel->ring) {
+        spdlog::error("[ShmOrderRspPublisher::publish] Failed to open {}",
+                      name);
+        Metrics::add(MC_PUBLISH_FAILED);
+        return;
+      }
+      iter = channels_.emplace(strategy_id, std::move(channel)).first;
+    }
+
+    iter->second->ring->push(*rsp);
+  }
+
+ private:
+  struct Channel {
+    SharedMemory shm;
+    OrderRspRing* ring = nullptr;
+  };
+
+  const ProtocolQueryCenter* proto_;
+  std::map<std::string, std::unique_ptr<Channel>> channels_;
+};
+
+class ShmOrderRspSubscriber : public OrderRspSubscriber {
+ public:
+  bool init(const ProtocolQueryCenter* proto, const std::string& strategy_id) {
+    auto* ring = attach_shm_object<OrderRspRing>(
+        &shm_, proto->order_rsp_shm_name(strategy_id));
+    if (!ring) return false;
+
+    reader_.attach(ring);
+    return true;
+  }
+
+  const OrderResponse* try_get_rsp() override {
+    return reader_.next(&rsp_) ? &rsp_ : nullptr;
+  }
+
+  uint64_t lost() const override { return reader_.lost(); }
+
+ private:
+  SharedMemory shm_;
+  OrderRspRingReader reader_;
+  OrderResponse rsp_{};
+};
+
+inline std::unique_ptr<OrderRspPublisher> create_order_rsp_publisher(
+    const std::string& transport, const ProtocolQueryCenter* proto,
+    bool pipelined = false) {
+  if (transport == IPC_REDIS)
+    return std::make_unique<RedisOrderRspPublisher>(pipelined);
+
+  if (transport == IPC_SHM)
+    return std::make_unique<ShmOrderRspPublisher>(proto);
+
+  spdlog::error("[create_order_rsp_publisher] Unknown transport: {}",
+                transport);
+  return nullptr;
+}
+
+inline std::unique_ptr<OrderRspSubscriber> create_order_rsp_subscriber(
+    const std::string& transport, const ProtocolQueryCenter* proto,
+    const std::string& strategy_id) {
+  if (transport == IPC_REDIS)
+    return std::make_unique<RedisOrderRspSubscriber>(strategy_id);
+
+  if (transport == IPC_SHM) {
+    auto subscriber = std::make_unique<ShmOrderRspSubscriber>();
+    if (!subscriber->init(proto, strategy_id)) {
+      spdlog::error("[create_order_rsp_subscriber] Failed to open {}",
+                    proto->order_rsp_shm_name(strategy_id));
+      return nullptr;
+    }
+    return subscriber;
+  }
+
+  spdlog::error("[create_order_rsp_subscriber] Unknown transport: {}",
+                transport);
+  return nullptr;
+}
+
+}  // namespace ft
+
+#endif  // FT_SRC_COMMON_ORDERRSPTRANSPORT_H_
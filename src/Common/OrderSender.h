@@ -3,13 +3,16 @@
 #ifndef FT_SRC_STRATEGY_ORDERSENDER_H_
 #define FT_SRC_STRATEGY_ORDERSENDER_H_
 
-#include <mutex>
+#include <spdlog/spdlog.h>
+
+#include <memory>
 #include <string>
 
+#include "Common/LatencyStats.h"
+#include "Common/TraderCmdTransport.h"
 #include "Core/Constants.h"
 #include "Core/ContractTable.h"
 #include "Core/Protocol.h"
-#include "IPC/redis.h"
 
 namespace ft {
 
@@ -19,10 +22,23 @@ class OrderSender {
     strncpy(strategy_id_, name.c_str(), sizeof(strategy_id_) - 1);
   }
 
+  /* 需与交易引擎配置的ipc_transport一致，须在set_account之前调用 */
+  void set_ipc_transport(const std::string& transport) {
+    ipc_transport_ = transport;
+  }
+
   void set_account(uint64_t account_id) {
     proto_.set_account(account_id);
+    cmd_sender_ = create_trader_cmd_sender(ipc_transport_, &proto_);
+    if (!cmd_sender_)
+      spdlog::error("[OrderSender::set_account] Failed to create cmd sender");
   }
 
+  /*
+   * 开启后每条指令都带上发出时间，引擎据此统计各阶段的延迟
+   */
+  void set_latency_trace(bool enabled) { latency_trace_ = enabled; }
+
   void buy_open(const std::string& ticker, int volume, double price,
                 uint64_t type = OrderType::FAK, uint32_t user_order_id = 0) {
     send_order(ticker, volume, Direction::BUY, Offset::OPEN, type, price,
@@ -66,8 +82,28 @@ class OrderSender {
     cmd.order_req.type = type;
     cmd.order_req.price = price;
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    cmd_redis_.publish(proto_.trader_cmd_topic(), &cmd, sizeof(cmd));
+    send_cmd(&cmd);
+  }
+
+  /*
+   * 批量报单，整批订单通过一条指令发给引擎，最多kMaxBatchOrders笔
+   */
+  void send_order_batch(const TraderOrderReq* reqs, uint32_t count) {
+    if (count == 0 || count > kMaxBatchOrders) {
+      spdlog::error("[OrderSender::send_order_batch] Invalid count {}",
+                    count);
+      return;
+    }
+
+    auto& cmd = batch_buf_.cmd;
+    cmd = TraderCommand{};
+    cmd.magic = TRADER_CMD_MAGIC;
+    cmd.type = NEW_ORDER_BATCH;
+    strncpy(cmd.strategy_id, strategy_id_, sizeof(cmd.strategy_id));
+    cmd.order_batch.count = count;
+    for (uint32_t i = 0; i < count; ++i) batch_buf_.order_reqs[i] = reqs[i];
+
+    send_cmd(&cmd);
   }
 
   void cancel_order(uint64_t order_id) {
@@ -76,8 +112,24 @@ class OrderSender {
     cmd.type = CANCEL_ORDER;
     cmd.cancel_req.order_id = order_id;
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    cmd_redis_.publish(proto_.trader_cmd_topic(), &cmd, sizeof(cmd));
+    send_cmd(&cmd);
+  }
+
+  /*
+   * 改单，volume或user_order_id为0时沿用原订单的
+   */
+  void replace_order(uint64_t order_id, double price, int volume = 0,
+                     uint32_t user_order_id = 0) {
+    TraderCommand cmd{};
+    cmd.magic = TRADER_CMD_MAGIC;
+    cmd.type = REPLACE_ORDER;
+    strncpy(cmd.strategy_id, strategy_id_, sizeof(cmd.strategy_id));
+    cmd.replace_req.order_id = order_id;
+    cmd.replace_req.price = price;
+    cmd.replace_req.volume = volume;
+    cmd.replace_req.user_order_id = user_order_id;
+
+    send_cmd(&cmd);
   }
 
   void cancel_for_ticker(const std::string& ticker) {
@@ -88,8 +140,7 @@ class OrderSender {
     cmd.type = CANCEL_TICKER;
     cmd.cancel_ticker_req.ticker_index = contract->index;
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    cmd_redis_.publish(proto_.trader_cmd_topic(), &cmd, sizeof(cmd));
+    send_cmd(&cmd);
   }
 
   void cancel_all() {
@@ -97,15 +148,54 @@ class OrderSender {
     cmd.magic = TRADER_CMD_MAGIC;
     cmd.type = CANCEL_ALL;
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    cmd_redis_.publish(proto_.trader_cmd_topic(), &cmd, sizeof(cmd));
+    send_cmd(&cmd);
+  }
+
+  /*
+   * 撤销本策略的所有未完成订单，不影响其他策略的订单
+   */
+  void cancel_strategy() {
+    TraderCommand cmd{};
+    cmd.magic = TRADER_CMD_MAGIC;
+    cmd.type = CANCEL_STRATEGY;
+    strncpy(cmd.strategy_id, strategy_id_, sizeof(cmd.strategy_id));
+
+    send_cmd(&cmd);
+  }
+
+  /*
+   * 请求引擎重新推送本策略所有未完成订单的状态
+   */
+  void query_orders() {
+    TraderCommand cmd{};
+    cmd.magic = TRADER_CMD_MAGIC;
+    cmd.type = QUERY_ORDERS;
+    strncpy(cmd.strategy_id, strategy_id_, sizeof(cmd.strategy_id));
+
+    send_cmd(&cmd);
+  }
+
+ private:
+  void send_cmd(TraderCommand* cmd) {
+    if (!cmd_sender_) {
+      spdlog::error("[OrderSender::send_cmd] No cmd sender. Type: {}",
+                    static_cast<uint32_t>(cmd->type));
+      return;
+    }
+
+    if (latency_trace_) cmd->send_time_ns = monotonic_ns();
+    if (!cmd_sender_->send(cmd))
+      spdlog::error("[OrderSender::send_cmd] Failed to send cmd. Type: {}",
+                    static_cast<uint32_t>(cmd->type));
   }
 
  private:
-  StrategyIdType strategy_id_;
-  RedisSession cmd_redis_;
-  std::mutex mutex_;
+  StrategyIdType strategy_id_{};
+  std::string ipc_transport_{IPC_REDIS};
+  std::unique_ptr<TraderCmdSender> cmd_sender_{nullptr};
   ProtocolQueryCenter proto_;
+  TraderCmdBuffer batch_buf_{};
+  bool latency_trace_ = false;
 };
 
 }  // namespace ft
@@ -1,22 +1,54 @@
 #ifndef FT_SRC_COMMON_POSITIONHELPER_H_
 #define FT_SRC_COMMON_POSITIONHELPER_H_
 
+#include <spdlog/spdlog.h>
+
 #include <cstring>
 #include <string>
 
+#include "Common/PositionTable.h"
+#include "Core/Account.h"
+#include "Core/Constants.h"
+#include "Core/ContractTable.h"
 #include "Core/Position.h"
 #include "Core/Protocol.h"
+#include "IPC/SharedMemory.h"
 #include "IPC/redis.h"
 
 namespace ft {
 
+/*
+ * ipc_transport为shm时从交易引擎发布的共享内存仓位表中读取，
+ * 不需要访问redis；否则每次查询都是一次redis GET
+ */
 class PositionHelper {
  public:
-  void set_account(uint64_t account) { proto_.set_account(account); }
+  /* 须在set_account之前调用 */
+  void set_ipc_transport(const std::string& transport) {
+    ipc_transport_ = transport;
+  }
+
+  void set_account(uint64_t account) {
+    proto_.set_account(account);
+
+    if (ipc_transport_ == IPC_SHM) {
+      pos_table_ =
+          attach_shm_object<PositionTable>(&pos_shm_, proto_.pos_shm_name());
+      if (!pos_table_)
+        spdlog::warn("[PositionHelper::set_account] Failed to open {}",
+                     proto_.pos_shm_name());
+    }
+  }
 
   Position get_position(const std::string& ticker) const {
     Position pos;
 
+    if (pos_table_) {
+      const auto* contract = ContractTable::get_by_ticker(ticker);
+      if (contract) pos_table_->load_position(contract->index, &pos);
+      return pos;
+    }
+
     auto reply = redis_.get(proto_.pos_key(ticker));
     if (reply->len == 0) return pos;
 
@@ -25,12 +57,33 @@ class PositionHelper {
   }
 
   double get_realized_pnl() const {
+    if (pos_table_) {
+      PnlRecord pnl;
+      pos_table_->load_pnl(&pnl);
+      return pnl.realized_pnl;
+    }
+
     auto reply = redis_.get(proto_.rpnl_key());
     if (reply->len == 0) return 0;
     return *reinterpret_cast<double*>(reply->str);
   }
 
+  /*
+   * 账户的资金快照，只有ipc_transport为shm时可用，否则返回空的账户
+   */
+  Account get_account() const {
+    Account account{};
+    if (pos_table_) pos_table_->load_account(&account);
+    return account;
+  }
+
   double get_float_pnl() const {
+    if (pos_table_) {
+      PnlRecord pnl;
+      pos_table_->load_pnl(&pnl);
+      return pnl.float_pnl;
+    }
+
     auto reply = redis_.get(proto_.fpnl_key());
     if (reply->len == 0) return 0;
     return *reinterpret_cast<double*>(reply->str);
@@ -39,6 +92,9 @@ class PositionHelper {
  private:
   RedisSession redis_;
   ProtocolQueryCenter proto_;
+  std::string ipc_transport_{IPC_REDIS};
+  SharedMemory pos_shm_;
+  const PositionTable* pos_table_ = nullptr;
 };
 
 };  // namespace ft
@@ -3,6 +3,7 @@
 #include "Common/PositionManager.h"
 
 #include <algorithm>
+#include <chrono>
 
 #include "Core/Constants.h"
 #include "Core/ContractTable.h"
@@ -10,22 +11,51 @@
 namespace ft {
 
 PositionManager::PositionManager(const std::string& ip, int port)
-    : redis_(ip, port) {}
+    : redis_(ip, port),
+      last_prices_(
+          std::make_unique<std::atomic<double>[]>(PositionTable::kMaxTickers)) {
+}
+
+PositionManager::~PositionManager() {
+  if (flusher_.joinable()) {
+    is_flushing_ = false;
+    flusher_.join();
+  }
+}
+
+void PositionManager::init(uint64_t account, uint64_t flush_interval_ms) {
+  resize(ContractTable::size() + 1);
 
-void PositionManager::init(uint64_t account) {
   proto_.set_account(account);
   auto reply = redis_.keys(fmt::format("{}*", proto_.pos_key_prefix()));
   for (size_t i = 0; i < reply->elements; ++i)
     redis_.del(reply->element[i]->str);
+  redis_.del(proto_.rpnl_key());
+  redis_.del(proto_.fpnl_key());
+
+  pos_table_ =
+      attach_shm_object<PositionTable>(&pos_shm_, proto_.pos_shm_name());
+  if (pos_table_)
+    pos_table_->clear();
+  else
+    spdlog::warn("[PositionManager::init] Failed to open {}",
+                 proto_.pos_shm_name());
+
+  // 后台线程从仓位表中读取最新的仓位，没有仓位表时只能同步写入
+  if (flush_interval_ms > 0 && pos_table_) {
+    write_behind_ = true;
+    flush_interval_ms_ = flush_interval_ms;
+    is_flushing_ = true;
+    flusher_ = std::thread(&PositionManager::flush_loop, this);
+  }
 }
 
 void PositionManager::set_position(const Position* pos) {
-  pos_map_.emplace(pos->ticker_index, *pos);
+  auto& slot_pos = find_or_create_pos(pos->ticker_index);
+  slot_pos = *pos;
 
-  const auto* contract = ContractTable::get_by_index(pos->ticker_index);
-  assert(contract);
-  auto key = proto_.pos_key(contract->ticker);
-  redis_.set(key, pos, sizeof(Position));
+  assert(ContractTable::get_by_index(pos->ticker_index));
+  publish(slot_pos);
 }
 
 void PositionManager::update_pending(uint32_t ticker_index, uint32_t direction,
@@ -52,9 +82,8 @@ void PositionManager::update_pending(uint32_t ticker_index, uint32_t direction,
     spdlog::warn("[Portfolio::update_pending] correct close_pending");
   }
 
-  const auto* contract = ContractTable::get_by_index(pos.ticker_index);
-  assert(contract);
-  redis_.set(proto_.pos_key(contract->ticker), &pos, sizeof(pos));
+  assert(ContractTable::get_by_index(pos.ticker_index));
+  publish(pos);
 }
 
 void PositionManager::update_traded(uint32_t ticker_index, uint32_t direction,
@@ -104,12 +133,12 @@ void PositionManager::update_traded(uint32_t ticker_index, uint32_t direction,
   }
   assert(contract->size > 0);
 
-  if (is_close) {  // 如果是平仓则计算已实现的盈亏
+  if (is_close) {  // 如果是平仓则累计已实现的盈亏
     if (direction == Direction::BUY)
-      realized_pnl_ =
+      realized_pnl_ +=
           contract->size * traded * (traded_price - pos_detail.cost_price);
     else
-      realized_pnl_ =
+      realized_pnl_ +=
           contract->size * traded * (pos_detail.cost_price - traded_price);
   } else if (pos_detail.holdings > 0) {  // 如果是开仓则计算当前持仓的成本价
     double cost = contract->size * (pos_detail.holdings - traded) *
@@ -118,36 +147,78 @@ void PositionManager::update_traded(uint32_t ticker_index, uint32_t direction,
     pos_detail.cost_price = cost / (pos_detail.holdings * contract->size);
   }
 
-  if (pos_detail.holdings == 0) {
+  // 持仓和成本价已经变化，按最新价立即重算浮动盈亏，不等下一个行情，
+  // 否则部分平仓后已实现的盈亏会和旧的浮动盈亏重复计算
+  double last_price =
+      PositionTable::is_valid_index(ticker_index)
+          ? last_prices_[ticker_index].load(std::memory_order_relaxed)
+          : 0;
+  if (last_price > 0) {
+    update_float_pnl(&pos, last_price);
+  } else if (pos_detail.holdings == 0) {
+    float_pnl_ -= pos_detail.float_pnl;
     pos_detail.float_pnl = 0;
-    pos_detail.cost_price = 0;
   }
+  if (pos_detail.holdings == 0) pos_detail.cost_price = 0;
 
-  redis_.set(proto_.pos_key(contract->ticker), &pos, sizeof(pos));
-  redis_.set("realized_pnl", &realized_pnl_, sizeof(realized_pnl_));
+  publish(pos);
+  publish_pnl();
 }
 
-void PositionManager::update_float_pnl(uint32_t ticker_index,
-                                       double last_price) {
-  auto* pos = find(ticker_index);
-  if (pos) {
-    const auto* contract = ContractTable::get_by_index(ticker_index);
-    if (!contract || contract->size <= 0) return;
+void PositionManager::mark_price(uint32_t ticker_index, double last_price) {
+  if (!PositionTable::is_valid_index(ticker_index) || last_price <= 0) return;
 
-    auto& lp = pos->long_pos;
-    auto& sp = pos->short_pos;
+  last_prices_[ticker_index].store(last_price, std::memory_order_relaxed);
+  mark_dirty_[ticker_index / 64].fetch_or(1ULL << (ticker_index % 64),
+                                          std::memory_order_release);
+}
 
-    if (lp.holdings > 0)
-      lp.float_pnl =
-          lp.holdings * contract->size * (last_price - lp.cost_price);
+void PositionManager::mark_to_market() {
+  bool changed = false;
+  std::size_t words = std::min(nonempty_.size(), kDirtyWords);
+  for (std::size_t i = 0; i < words; ++i) {
+    // 没有仓位的合约只需保留last_prices_，开仓成交时update_traded会按它
+    // 计算浮动盈亏
+    uint64_t bits = mark_dirty_[i].exchange(0, std::memory_order_acquire) &
+                    nonempty_[i];
+    while (bits) {
+      uint32_t ticker_index = i * 64 + __builtin_ctzll(bits);
+      bits &= bits - 1;
+
+      auto& pos = slots_[ticker_index].pos;
+      double last_price =
+          last_prices_[ticker_index].load(std::memory_order_relaxed);
+      if (update_float_pnl(&pos, last_price)) {
+        publish(pos);
+        changed = true;
+      }
+    }
+  }
 
-    if (sp.holdings > 0)
-      sp.float_pnl =
-          sp.holdings * contract->size * (sp.cost_price - last_price);
+  if (changed) publish_pnl();
+}
 
-    if (lp.holdings > 0 || sp.holdings > 0)
-      redis_.set(proto_.pos_key(contract->ticker), pos, sizeof(*pos));
-  }
+bool PositionManager::update_float_pnl(Position* pos, double last_price) {
+  const auto* contract = ContractTable::get_by_index(pos->ticker_index);
+  if (!contract || contract->size <= 0) return false;
+
+  auto& lp = pos->long_pos;
+  auto& sp = pos->short_pos;
+  double old_pnl = lp.float_pnl + sp.float_pnl;
+
+  lp.float_pnl =
+      lp.holdings > 0
+          ? lp.holdings * contract->size * (last_price - lp.cost_price)
+          : 0;
+  sp.float_pnl =
+      sp.holdings > 0
+          ? sp.holdings * contract->size * (sp.cost_price - last_price)
+          : 0;
+
+  double new_pnl = lp.float_pnl + sp.float_pnl;
+  if (new_pnl == old_pnl) return false;
+  float_pnl_ += new_pnl - old_pnl;
+  return true;
 }
 
 void PositionManager::update_on_query_trade(uint32_t ticker_index,
@@ -162,4 +233,87 @@ void PositionManager::update_on_query_trade(uint32_t ticker_index,
   // redis_.set(proto_.pos_key(contract->ticker), pos, sizeof(*pos));
 }
 
+void PositionManager::resize(std::size_t size) {
+  if (size <= slots_.size()) return;
+  slots_.resize(size);
+  nonempty_.resize((size + 63) / 64, 0);
+}
+
+void PositionManager::update_nonempty(const Position& pos) {
+  auto& lp = pos.long_pos;
+  auto& sp = pos.short_pos;
+  bool nonempty = lp.holdings != 0 || lp.frozen != 0 ||
+                  lp.open_pending != 0 || lp.close_pending != 0 ||
+                  sp.holdings != 0 || sp.frozen != 0 ||
+                  sp.open_pending != 0 || sp.close_pending != 0;
+
+  uint64_t bit = 1ULL << (pos.ticker_index % 64);
+  auto& word = nonempty_[pos.ticker_index / 64];
+  word = nonempty ? word | bit : word & ~bit;
+}
+
+void PositionManager::publish(const Position& pos) {
+  update_nonempty(pos);
+
+  if (pos_table_) pos_table_->store_position(pos);
+
+  if (write_behind_ && PositionTable::is_valid_index(pos.ticker_index)) {
+    dirty_[pos.ticker_index / 64].fetch_or(1ULL << (pos.ticker_index % 64),
+                                           std::memory_order_release);
+  } else {
+    redis_.set(proto_.pos_key(pos.ticker_index), &pos, sizeof(pos));
+  }
+}
+
+void PositionManager::publish_pnl() {
+  if (pos_table_) {
+    PnlRecord pnl;
+    pnl.realized_pnl = realized_pnl_;
+    pnl.float_pnl = float_pnl_;
+    pos_table_->store_pnl(pnl);
+  }
+
+  if (write_behind_) {
+    pnl_dirty_.store(true, std::memory_order_release);
+  } else {
+    redis_.set(proto_.rpnl_key(), &realized_pnl_, sizeof(realized_pnl_));
+    redis_.set(proto_.fpnl_key(), &float_pnl_, sizeof(float_pnl_));
+  }
+}
+
+void PositionManager::flush_loop() {
+  while (is_flushing_) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(flush_interval_ms_));
+    flush();
+  }
+
+  flush();  // 退出前把最后一个周期的更新写入
+}
+
+void PositionManager::flush() {
+  Position pos;
+  for (std::size_t i = 0; i < kDirtyWords; ++i) {
+    uint64_t bits = dirty_[i].exchange(0, std::memory_order_acquire);
+    while (bits) {
+      uint32_t ticker_index = i * 64 + __builtin_ctzll(bits);
+      bits &= bits - 1;
+
+      if (!ContractTable::get_by_index(ticker_index)) continue;
+      pos_table_->load_position(ticker_index, &pos);
+      redis_.append_set(proto_.pos_key(ticker_index), &pos, sizeof(pos));
+    }
+  }
+
+  if (pnl_dirty_.exchange(false, std::memory_order_acquire)) {
+    PnlRecord pnl;
+    pos_table_->load_pnl(&pnl);
+    redis_.append_set(proto_.rpnl_key(), &pnl.realized_pnl,
+                      sizeof(pnl.realized_pnl));
+    redis_.append_set(proto_.fpnl_key(), &pnl.float_pnl,
+                      sizeof(pnl.float_pnl));
+  }
+
+  redis_.flush_pipeline();
+}
+
 }  // namespace ft
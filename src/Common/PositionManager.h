@@ -3,12 +3,16 @@
 #ifndef FT_SRC_COMMON_POSITIONMANAGER_H_
 #define FT_SRC_COMMON_POSITIONMANAGER_H_
 
-#include <map>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "Common/PositionTable.h"
 #include "Core/Position.h"
 #include "Core/Protocol.h"
+#include "IPC/SharedMemory.h"
 #include "IPC/redis.h"
 
 namespace ft {
@@ -17,7 +21,14 @@ class PositionManager {
  public:
   PositionManager(const std::string& ip, int port);
 
-  void init(uint64_t account);
+  ~PositionManager();
+
+  /*
+   * flush_interval_ms为0时每次更新都同步写入redis；大于0时只标记更新的
+   * 合约，由后台线程每隔flush_interval_ms把标记的仓位合并后通过pipeline
+   * 一次性写入redis，同一合约在一个周期内的多次更新只写一次
+   */
+  void init(uint64_t account, uint64_t flush_interval_ms = 0);
 
   void set_position(const Position* pos);
 
@@ -27,32 +38,111 @@ class PositionManager {
   void update_traded(uint32_t ticker_index, uint32_t direction, uint32_t offset,
                      int traded, double traded_price);
 
-  void update_float_pnl(uint32_t ticker_index, double last_price);
+  /*
+   * 记录合约的最新价，可以在任意线程(如行情回调线程)中调用。同一合约的
+   * 多次调用只保留最后一个价格，由mark_to_market统一处理
+   */
+  void mark_price(uint32_t ticker_index, double last_price);
+
+  /*
+   * 按mark_price记录的最新价更新有持仓的合约的浮动盈亏及账户的浮动盈亏
+   * 合计，并发布发生变化的仓位。只能在交易引擎线程中调用，调用的频率即
+   * 浮动盈亏的发布频率
+   */
+  void mark_to_market();
 
   void update_on_query_trade(uint32_t ticker_index, uint32_t direction,
                              uint32_t offset, int closed_volume);
 
+  double realized_pnl() const { return realized_pnl_; }
+
+  // 截至上一次mark_to_market的浮动盈亏合计
+  double float_pnl() const { return float_pnl_; }
+
+  /*
+   * 没有持仓也没有挂单时返回nullptr
+   */
   const Position* find(uint32_t ticker_index) const {
     return const_cast<PositionManager*>(this)->find(ticker_index);
   }
 
+  /*
+   * 按ticker_index从小到大遍历所有有持仓或挂单的仓位
+   */
+  template <class Func>
+  void for_each(Func&& func) const {
+    for (std::size_t i = 0; i < nonempty_.size(); ++i) {
+      uint64_t bits = nonempty_[i];
+      while (bits) {
+        uint32_t ticker_index = i * 64 + __builtin_ctzll(bits);
+        bits &= bits - 1;
+        func(slots_[ticker_index].pos);
+      }
+    }
+  }
+
  private:
+  bool is_nonempty(uint32_t ticker_index) const {
+    return ticker_index < slots_.size() &&
+           (nonempty_[ticker_index / 64] >> (ticker_index % 64)) & 1;
+  }
+
   Position* find(uint32_t ticker_index) {
-    auto iter = pos_map_.find(ticker_index);
-    if (iter == pos_map_.end()) return nullptr;
-    return &iter->second;
+    if (!is_nonempty(ticker_index)) return nullptr;
+    return &slots_[ticker_index].pos;
   }
 
   Position& find_or_create_pos(uint32_t ticker_index) {
-    auto& pos = pos_map_[ticker_index];
+    if (ticker_index >= slots_.size()) resize(ticker_index + 1);
+    auto& pos = slots_[ticker_index].pos;
     pos.ticker_index = ticker_index;
     return pos;
   }
 
+  void resize(std::size_t size);
+
+  void update_nonempty(const Position& pos);
+
+  /*
+   * 以last_price重新计算仓位的浮动盈亏并增量更新账户的合计，返回是否有
+   * 变化
+   */
+  bool update_float_pnl(Position* pos, double last_price);
+
+  void publish(const Position& pos);
+
+  void publish_pnl();
+
+  void flush_loop();
+
+  void flush();
+
  private:
   RedisSession redis_;
-  std::map<uint32_t, Position> pos_map_;
+  SharedMemory pos_shm_;
+  PositionTable* pos_table_ = nullptr;
+
+  static constexpr std::size_t kDirtyWords = PositionTable::kMaxTickers / 64;
+  bool write_behind_ = false;
+  uint64_t flush_interval_ms_ = 0;
+  std::atomic<uint64_t> dirty_[kDirtyWords]{};
+  std::atomic<bool> pnl_dirty_{false};
+  // 行情线程写入的最新价，mark_dirty_标记自上次mark_to_market后有新价格的
+  // 合约
+  std::unique_ptr<std::atomic<double>[]> last_prices_;
+  std::atomic<uint64_t> mark_dirty_[kDirtyWords]{};
+  std::atomic<bool> is_flushing_{false};
+  std::thread flusher_;
+
+  // 仓位按ticker_index稠密存放，每个仓位独占缓存行，下标0不使用。
+  // nonempty_中的每一位标记对应的仓位是否有持仓或挂单
+  struct alignas(64) PositionSlot {
+    Position pos;
+  };
+  std::vector<PositionSlot> slots_;
+  std::vector<uint64_t> nonempty_;
   double realized_pnl_ = 0;
+  double float_pnl_ = 0;
   ProtocolQueryCenter proto_;
 };
 
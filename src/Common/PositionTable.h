@@ -0,0 +1,89 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_COMMON_POSITIONTABLE_H_
+#define FT_SRC_COMMON_POSITIONTABLE_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "Core/Account.h"
+#include "Core/Position.h"
+#include "IPC/SeqLock.h"
+
+namespace ft {
+
+struct PnlRecord {
+  double realized_pnl = 0;
+  double float_pnl = 0;
+};
+
+/*
+ * 共享内存中的仓位表，由交易引擎中的PositionManager写入，策略直接读取，
+ * 代替每次查询仓位时对redis的GET
+ *
+ * 仓位按ticker_index稠密存放，每条仓位记录、账户的盈亏记录及资金记录
+ * 各自由一个顺序锁保护，策略读到的总是某一时刻的完整记录。资金记录由
+ * AccountLedger写入
+ */
+class PositionTable {
+ public:
+  static constexpr uint32_t kMagic = 0x706f7374;
+  static constexpr std::size_t kMaxTickers = 16384;
+
+  void init() {
+    pnl_.init();
+    account_.init();
+    for (auto& pos : positions_) pos.init();
+    magic_.store(kMagic, std::memory_order_release);
+  }
+
+  bool is_ready() const {
+    return magic_.load(std::memory_order_acquire) == kMagic;
+  }
+
+  /*
+   * 交易引擎重启时清空上一次运行留下的数据
+   */
+  void clear() {
+    Position empty_pos{};
+    for (std::size_t i = 0; i < kMaxTickers; ++i) {
+      empty_pos.ticker_index = i;
+      positions_[i].store(empty_pos);
+    }
+    pnl_.store(PnlRecord{});
+    account_.store(Account{});
+  }
+
+  static bool is_valid_index(uint32_t ticker_index) {
+    return ticker_index < kMaxTickers;
+  }
+
+  void store_position(const Position& pos) {
+    if (is_valid_index(pos.ticker_index))
+      positions_[pos.ticker_index].store(pos);
+  }
+
+  bool load_position(uint32_t ticker_index, Position* pos) const {
+    if (!is_valid_index(ticker_index)) return false;
+    positions_[ticker_index].load(pos);
+    return true;
+  }
+
+  void store_pnl(const PnlRecord& pnl) { pnl_.store(pnl); }
+
+  void load_pnl(PnlRecord* pnl) const { pnl_.load(pnl); }
+
+  void store_account(const Account& account) { account_.store(account); }
+
+  void load_account(Account* account) const { account_.load(account); }
+
+ private:
+  std::atomic<uint32_t> magic_;
+  SeqLocked<PnlRecord> pnl_;
+  SeqLocked<Account> account_;
+  SeqLocked<Position> positions_[kMaxTickers];
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_COMMON_POSITIONTABLE_H_
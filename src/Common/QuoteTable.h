@@ -0,0 +1,158 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_COMMON_QUOTETABLE_H_
+#define FT_SRC_COMMON_QUOTETABLE_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "Core/TickData.h"
+#include "Utils/Misc.h"
+
+namespace ft {
+
+/*
+ * 某个合约在某一时刻的最新行情
+ */
+struct QuoteSnapshot {
+  uint64_t update_seq = 0;  // 该合约的行情更新次数，为0表示还没有行情
+  uint64_t time_sec = 0;
+  uint64_t time_ms = 0;
+  double last_price = 0;
+  uint64_t volume = 0;
+  double ask[kMarketLevel]{0};
+  double bid[kMarketLevel]{0};
+  int ask_volume[kMarketLevel]{0};
+  int bid_volume[kMarketLevel]{0};
+};
+
+/*
+ * 共享内存中的最新行情表，覆盖ContractTable中的所有合约，由交易引擎在
+ * 收到tick时写入，策略可以随时以O(1)的代价读取任意合约的最新行情，
+ * 不需要订阅并自行缓存
+ *
+ * 按字段分别存放(struct of arrays)，每个数组都从缓存行边界开始，下标为
+ * ticker_index。每个合约有一个顺序锁，序号的一半即为该合约的更新次数
+ *
+ * 只能有一个写者
+ */
+class QuoteTable {
+ public:
+  static constexpr uint32_t kMagic = 0x71746174;
+  static constexpr std::size_t kMaxTickers = 16384;
+
+  void init() {
+    for (auto& seq : seq_) seq.store(0, std::memory_order_relaxed);
+    magic_.store(kMagic, std::memory_order_release);
+  }
+
+  bool is_ready() const {
+    return magic_.load(std::memory_order_acquire) == kMagic;
+  }
+
+  /*
+   * 交易引擎重启时清空上一次运行留下的行情。合约表可能已经变化，旧的行情
+   * 会对应到错误的合约；引擎异常退出时还可能留下奇数的序号，使读者一直
+   * 自旋。清空期间每个合约的序号先置为奇数，读者会重试
+   */
+  void clear() {
+    for (std::size_t i = 0; i < kMaxTickers; ++i) {
+      seq_[i].store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+
+      time_sec_[i] = 0;
+      time_ms_[i] = 0;
+      last_price_[i] = 0;
+      volume_[i] = 0;
+      for (std::size_t level = 0; level < kMarketLevel; ++level) {
+        ask_[level][i] = 0;
+        bid_[level][i] = 0;
+        ask_volume_[level][i] = 0;
+        bid_volume_[level][i] = 0;
+      }
+
+      seq_[i].store(0, std::memory_order_release);
+    }
+  }
+
+  static bool is_valid_index(uint32_t ticker_index) {
+    return ticker_index < kMaxTickers;
+  }
+
+  void update(const TickData& tick) {
+    uint32_t i = tick.ticker_index;
+    if (!is_valid_index(i)) return;
+
+    uint64_t seq = seq_[i].load(std::memory_order_relaxed);
+    seq_[i].store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    time_sec_[i] = tick.time_sec;
+    time_ms_[i] = tick.time_ms;
+    last_price_[i] = tick.last_price;
+    volume_[i] = tick.volume;
+    for (std::size_t level = 0; level < kMarketLevel; ++level) {
+      ask_[level][i] = tick.ask[level];
+      bid_[level][i] = tick.bid[level];
+      ask_volume_[level][i] = tick.ask_volume[level];
+      bid_volume_[level][i] = tick.bid_volume[level];
+    }
+
+    seq_[i].store(seq + 2, std::memory_order_release);
+  }
+
+  /*
+   * 读取一份完整的快照，写者正在写入时自旋重试
+   */
+  bool load(uint32_t ticker_index, QuoteSnapshot* quote) const {
+    uint32_t i = ticker_index;
+    if (!is_valid_index(i)) return false;
+
+    for (;;) {
+      uint64_t seq = seq_[i].load(std::memory_order_acquire);
+      if (seq & 1) {
+        cpu_relax();
+        continue;
+      }
+
+      quote->update_seq = seq / 2;
+      quote->time_sec = time_sec_[i];
+      quote->time_ms = time_ms_[i];
+      quote->last_price = last_price_[i];
+      quote->volume = volume_[i];
+      for (std::size_t level = 0; level < kMarketLevel; ++level) {
+        quote->ask[level] = ask_[level][i];
+        quote->bid[level] = bid_[level][i];
+        quote->ask_volume[level] = ask_volume_[level][i];
+        quote->bid_volume[level] = bid_volume_[level][i];
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_[i].load(std::memory_order_relaxed) == seq) return true;
+    }
+  }
+
+  /*
+   * 该合约的行情更新次数，可用于判断行情自上次读取后是否有变化
+   */
+  uint64_t update_seq(uint32_t ticker_index) const {
+    if (!is_valid_index(ticker_index)) return 0;
+    return seq_[ticker_index].load(std::memory_order_acquire) / 2;
+  }
+
+ private:
+  std::atomic<uint32_t> magic_;
+  alignas(64) std::atomic<uint64_t> seq_[kMaxTickers];
+  alignas(64) uint64_t time_sec_[kMaxTickers];
+  alignas(64) uint64_t time_ms_[kMaxTickers];
+  alignas(64) double last_price_[kMaxTickers];
+  alignas(64) uint64_t volume_[kMaxTickers];
+  alignas(64) double ask_[kMarketLevel][kMaxTickers];
+  alignas(64) double bid_[kMarketLevel][kMaxTickers];
+  alignas(64) int ask_volume_[kMarketLevel][kMaxTickers];
+  alignas(64) int bid_volume_[kMarketLevel][kMaxTickers];
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_COMMON_QUOTETABLE_H_
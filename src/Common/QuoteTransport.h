@@ -0,0 +1,341 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_COMMON_QUOTETRANSPORT_H_
+#define FT_SRC_COMMON_QUOTETRANSPORT_H_
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Core/Constants.h"
+#include "Core/Contract.h"
+#include "Core/ContractTable.h"
+#include "Core/Protocol.h"
+#include "Core/TickData.h"
+#include "IPC/BroadcastRing.h"
+#include "IPC/SharedMemory.h"
+#include "IPC/redis.h"
+#include "Utils/Misc.h"
+
+namespace ft {
+
+/*
+ * 行情从交易引擎转发到策略的通道，目前支持两种方式：
+ * redis: 通过redis的publish/subscribe转发，每个合约一个topic
+ * shm:   通过/dev/shm下的广播环形队列转发，每个账户一个队列，
+ *        引擎写入，任意数量的策略进程读取并按订阅的合约过滤
+ */
+inline constexpr std::size_t kQuoteRingSize = 4096;
+using QuoteRing = BroadcastRing<TickData, kQuoteRingSize>;
+using QuoteRingReader = BroadcastRingReader<TickData, kQuoteRingSize>;
+
+class QuotePublisher {
+ public:
+  virtual ~QuotePublisher() {}
+
+  virtual void publish(const Contract* contract, const TickData* tick) = 0;
+
+  /*
+   * 批量发布时，发出之前publish的所有数据
+   */
+  virtual void flush() {}
+};
+
+class QuoteSubscriber {
+ public:
+  virtual ~QuoteSubscriber() {}
+
+  virtual void subscribe(const std::vector<std::string>& tickers) = 0;
+
+  /*
+   * 对这些合约启用合并模式：策略处理不过来时，每个合约只保留最新的一笔
+   * tick，积压的旧tick直接被覆盖，策略看到的总是最新行情
+   */
+  void conflate(const std::vector<std::string>& tickers) {
+    for (const auto& ticker : tickers) {
+      auto contract = ContractTable::get_by_ticker(ticker);
+      if (!contract) {
+        spdlog::error("[QuoteSubscriber::conflate] Unknown ticker: {}",
+                      ticker);
+        continue;
+      }
+
+      if (contract->index >= conflated_.size()) {
+        conflated_.resize(contract->index + 1, false);
+        slots_.resize(contract->index + 1);
+        dirty_.resize(contract->index / 64 + 1, 0);
+      }
+      conflated_[contract->index] = true;
+    }
+  }
+
+  /*
+   * 阻塞直到收到已订阅合约的tick，返回的指针在下次调用前有效
+   *
+   * 有合约启用了合并模式时，先取出所有已到达的tick，非合并模式的tick
+   * 按到达顺序立即返回，合并模式的tick存入槽位，然后从有更新的槽位中
+   * 轮流返回
+   */
+  const TickData* get_tick() {
+    if (conflated_.empty()) return next_tick(true);
+
+    for (;;) {
+      while (auto tick = next_tick(false)) {
+        if (!is_conflated(tick->ticker_index)) return tick;
+        store_conflated(tick);
+      }
+
+      if (dirty_count_ > 0) return pop_conflated();
+
+      auto tick = next_tick(true);
+      if (!is_conflated(tick->ticker_index)) return tick;
+      store_conflated(tick);
+    }
+  }
+
+  /*
+   * 非阻塞版本的get_tick，没有tick时返回nullptr
+   */
+  const TickData* try_get_tick() {
+    if (conflated_.empty()) return next_tick(false);
+
+    while (auto tick = next_tick(false)) {
+      if (!is_conflated(tick->ticker_index)) return tick;
+      store_conflated(tick);
+    }
+
+    if (dirty_count_ > 0) return pop_conflated();
+    return nullptr;
+  }
+
+  /*
+   * 可用于poll/epoll等待行情到达的文件描述符，没有时返回-1
+   */
+  virtual int fd() const { return -1; }
+
+ protected:
+  /*
+   * 读取下一笔已订阅合约的tick，block为false时没有tick立即返回nullptr。
+   * 返回的指针在下次调用前有效
+   */
+  virtual const TickData* next_tick(bool block) = 0;
+
+ private:
+  bool is_conflated(uint32_t ticker_index) const {
+    return ticker_index < conflated_.size() && conflated_[ticker_index];
+  }
+
+  void store_conflated(const TickData* tick) {
+    uint32_t index = tick->ticker_index;
+    slots_[index] = *tick;
+
+    uint64_t bit = 1ULL << (index % 64);
+    if ((dirty_[index / 64] & bit) == 0) {
+      dirty_[index / 64] |= bit;
+      ++dirty_count_;
+    }
+  }
+
+  /*
+   * 从上一次返回的合约之后开始查找，避免更新频繁的合约饿死其他合约
+   */
+  const TickData* pop_conflated() {
+    std::size_t words = dirty_.size();
+    std::size_t word = cursor_ / 64;
+    uint64_t mask = ~0ULL << (cursor_ % 64);
+
+    for (std::size_t i = 0; i <= words; ++i) {
+      std::size_t w = (word + i) % words;
+      uint64_t bits = dirty_[w] & (i == 0 ? mask : ~0ULL);
+      if (bits == 0) continue;
+
+      std::size_t index = w * 64 + __builtin_ctzll(bits);
+      dirty_[w] &= ~(1ULL << (index % 64));
+      --dirty_count_;
+      cursor_ = (index + 1) % (words * 64);
+      return &slots_[index];
+    }
+
+    return nullptr;
+  }
+
+ private:
+  std::vector<bool> conflated_;
+  std::vector<TickData> slots_;
+  std::vector<uint64_t> dirty_;
+  std::size_t dirty_count_ = 0;
+  std::size_t cursor_ = 0;
+};
+
+/*
+ * pipelined为true时publish只把命令写入缓冲区，由flush一次性发出
+ */
+class RedisQuotePublisher : public QuotePublisher {
+ public:
+  RedisQuotePublisher(const ProtocolQueryCenter* proto, bool pipelined)
+      : proto_(proto), pipelined_(pipelined) {}
+
+  void publish(const Contract* contract, const TickData* tick) override {
+    const auto& topic = proto_->quote_key(contract->index);
+    if (pipelined_)
+      redis_.append_publish(topic, tick, sizeof(TickData));
+    else
+      redis_.publish(topic, tick, sizeof(TickData));
+  }
+
+  void flush() override { redis_.flush_pipeline(); }
+
+ private:
+  const ProtocolQueryCenter* proto_;
+  bool pipelined_;
+  RedisSession redis_{};
+};
+
+class RedisQuoteSubscriber : public QuoteSubscriber {
+ public:
+  explicit RedisQuoteSubscriber(const ProtocolQueryCenter* proto)
+      : proto_(proto) {}
+
+  void subscribe(const std::vector<std::string>& tickers) override {
+    std::vector<std::string> topics;
+    for (const auto& ticker : tickers)
+      topics.emplace_back(proto_->quote_key(ticker));
+    redis_.subscribe(topics);
+  }
+
+  int fd() const override { return redis_.fd(); }
+
+ protected:
+  const TickData* next_tick(bool block) override {
+    for (;;) {
+      reply_ = block ? redis_.get_sub_reply() : redis_.try_get_sub_reply();
+      if (!reply_) {
+        if (block) continue;
+        return nullptr;
+      }
+
+      // 过滤掉订阅确认等非message类型的回复
+      if (reply_->type != REDIS_REPLY_ARRAY || reply_->elements != 3 ||
+          strcmp(reply_->element[0]->str, "message") != 0 ||
+          reply_->element[2]->len != sizeof(TickData))
+        continue;
+
+      return reinterpret_cast<const TickData*>(reply_->element[2]->str);
+    }
+  }
+
+ private:
+  const ProtocolQueryCenter* proto_;
+  RedisSession redis_{};
+  RedisReply reply_{nullptr};
+};
+
+class ShmQuotePublisher : public QuotePublisher {
+ public:
+  bool init(const ProtocolQueryCenter* proto) {
+    ring_ = attach_shm_object<QuoteRing>(&shm_, proto->quote_shm_name());
+    return ring_ != nullptr;
+  }
+
+  void publish(const Contract* contract, const TickData* tick) override {
+    UNUSED(contract);
+    ring_->push(*tick);
+  }
+
+ private:
+  SharedMemory shm_;
+  QuoteRing* ring_ = nullptr;
+};
+
+class ShmQuoteSubscriber : public QuoteSubscriber {
+ public:
+  bool init(const ProtocolQueryCenter* proto) {
+    auto* ring = attach_shm_object<QuoteRing>(&shm_, proto->quote_shm_name());
+    if (!ring) return false;
+
+    reader_.attach(ring);
+    return true;
+  }
+
+  void subscribe(const std::vector<std::string>& tickers) override {
+    for (const auto& ticker : tickers) {
+      auto contract = ContractTable::get_by_ticker(ticker);
+      if (!contract) {
+        spdlog::error("[ShmQuoteSubscriber::subscribe] Unknown ticker: {}",
+                      ticker);
+        continue;
+      }
+
+      if (contract->index >= subscribed_.size())
+        subscribed_.resize(contract->index + 1, false);
+      subscribed_[contract->index] = true;
+    }
+  }
+
+ protected:
+  const TickData* next_tick(bool block) override {
+    for (;;) {
+      if (!reader_.next(&tick_)) {
+        if (!block) return nullptr;
+        cpu_relax();
+        continue;
+      }
+
+      if (tick_.ticker_index < subscribed_.size() &&
+          subscribed_[tick_.ticker_index])
+        return &tick_;
+    }
+  }
+
+ private:
+  SharedMemory shm_;
+  QuoteRingReader reader_;
+  std::vector<bool> subscribed_;
+  TickData tick_{};
+};
+
+inline std::unique_ptr<QuotePublisher> create_quote_publisher(
+    const std::string& transport, const ProtocolQueryCenter* proto,
+    bool pipelined = false) {
+  if (transport == IPC_REDIS)
+    return std::make_unique<RedisQuotePublisher>(proto, pipelined);
+
+  if (transport == IPC_SHM) {
+    auto publisher = std::make_unique<ShmQuotePublisher>();
+    if (!publisher->init(proto)) {
+      spdlog::error("[create_quote_publisher] Failed to open {}",
+                    proto->quote_shm_name());
+      return nullptr;
+    }
+    return publisher;
+  }
+
+  spdlog::error("[create_quote_publisher] Unknown transport: {}", transport);
+  return nullptr;
+}
+
+inline std::unique_ptr<QuoteSubscriber> create_quote_subscriber(
+    const std::string& transport, const ProtocolQueryCenter* proto) {
+  if (transport == IPC_REDIS)
+    return std::make_unique<RedisQuoteSubscriber>(proto);
+
+  if (transport == IPC_SHM) {
+    auto subscriber = std::make_unique<ShmQuoteSubscriber>();
+    if (!subscriber->init(proto)) {
+      spdlog::error("[create_quote_subscriber] Failed to open {}",
+                    proto->quote_shm_name());
+      return nullptr;
+    }
+    return subscriber;
+  }
+
+  spdlog::error("[create_quote_subscriber] Unknown transport: {}", transport);
+  return nullptr;
+}
+
+}  // namespace ft
+
+#endif  // FT_SRC_COMMON_QUOTETRANSPORT_H_
@@ -0,0 +1,61 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_COMMON_STRATEGYIDTABLE_H_
+#define FT_SRC_COMMON_STRATEGYIDTABLE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Core/Protocol.h"
+
+namespace ft {
+
+/*
+ * 把策略ID映射为从1开始的小整数，订单中只保存该整数，0表示不属于任何
+ * 策略(如手工下单)。策略数量很少，线性查找即可，只有第一次出现的策略ID
+ * 才会分配内存。最多kMaxStrategies个策略，超出时intern返回kNone
+ */
+class StrategyIdTable {
+ public:
+  static constexpr uint32_t kNone = 0;
+  static constexpr uint32_t kMaxStrategies = 256;
+
+  StrategyIdTable() {
+    names_.reserve(kMaxStrategies);
+    names_.emplace_back();
+  }
+
+  uint32_t intern(const char* strategy_id) {
+    if (strategy_id[0] == 0) return kNone;
+
+    uint32_t index = find(strategy_id);
+    if (index != kNone) return index;
+    if (names_.size() >= kMaxStrategies) return kNone;
+
+    names_.emplace_back(strategy_id,
+                        strnlen(strategy_id, sizeof(StrategyIdType)));
+    return names_.size() - 1;
+  }
+
+  uint32_t find(const char* strategy_id) const {
+    if (strategy_id[0] == 0) return kNone;
+
+    for (uint32_t i = 1; i < names_.size(); ++i) {
+      if (strncmp(names_[i].c_str(), strategy_id, sizeof(StrategyIdType)) ==
+          0)
+        return i;
+    }
+    return kNone;
+  }
+
+  const std::string& name(uint32_t index) const { return names_[index]; }
+
+ private:
+  std::vector<std::string> names_;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_COMMON_STRATEGYIDTABLE_H_
@@ -0,0 +1,270 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_COMMON_TRADERCMDTRANSPORT_H_
+#define FT_SRC_COMMON_TRADERCMDTRANSPORT_H_
+
+#include <spdlog/spdlog.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Core/Constants.h"
+#include "Core/Protocol.h"
+#include "IPC/MpscQueue.h"
+#include "IPC/SharedMemory.h"
+#include "IPC/redis.h"
+#include "Utils/Misc.h"
+
+namespace ft {
+
+/*
+ * 交易指令从策略(或工具)发往交易引擎的通道，与行情通道一样由
+ * ipc_transport决定：
+ * redis: 通过redis的publish/subscribe发送，每次发送都是一次阻塞的往返
+ * shm:   通过/dev/shm下的多写单读无锁队列发送，引擎忙等或在futex上等待
+ *
+ * 批量报单是变长指令：redis下整条指令作为一条消息发送；shm下占用队列中
+ * 连续的count+1个槽位，第一个槽位是指令头，之后每个槽位的order_req是
+ * 一笔订单
+ */
+inline constexpr std::size_t kTraderCmdQueueSize = 1024;
+using TraderCmdQueue = MpscQueue<TraderCommand, kTraderCmdQueueSize>;
+
+class TraderCmdSender {
+ public:
+  virtual ~TraderCmdSender() {}
+
+  virtual bool send(const TraderCommand* cmd) = 0;
+};
+
+class TraderCmdReceiver {
+ public:
+  virtual ~TraderCmdReceiver() {}
+
+  /*
+   * 等待下一个指令，可能因超时等原因返回nullptr。
+   * 返回的指针在下次调用前有效，批量报单的订单紧跟在返回的指令之后
+   */
+  virtual const TraderCommand* get_cmd() = 0;
+};
+
+class RedisTraderCmdSender : public TraderCmdSender {
+ public:
+  explicit RedisTraderCmdSender(const ProtocolQueryCenter* proto)
+      : proto_(proto) {}
+
+  bool send(const TraderCommand* cmd) override {
+    std::size_t size = trader_cmd_size(cmd);
+    if (size == 0) return false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    redis_.publish(proto_->trader_cmd_topic(), cmd, size);
+    return true;
+  }
+
+ private:
+  const ProtocolQueryCenter* proto_;
+  RedisSession redis_{};
+  std::mutex mutex_{};
+};
+
+class RedisTraderCmdReceiver : public TraderCmdReceiver {
+ public:
+  explicit RedisTraderCmdReceiver(const ProtocolQueryCenter* proto) {
+    redis_.subscribe({proto->trader_cmd_topic()});
+  }
+
+  const TraderCommand* get_cmd() override {
+    reply_ = redis_.get_sub_reply();
+    if (!reply_ || reply_->type != REDIS_REPLY_ARRAY ||
+        reply_->elements != 3 ||
+        reply_->element[2]->len < sizeof(TraderCommand))
+      return nullptr;
+
+    auto cmd = reinterpret_cast<const TraderCommand*>(reply_->element[2]->str);
+    std::size_t size = trader_cmd_size(cmd);
+    if (size == 0 || reply_->element[2]->len < size) return nullptr;
+    return cmd;
+  }
+
+ private:
+  RedisSession redis_{};
+  RedisReply reply_{nullptr};
+};
+
+class ShmTraderCmdSender : public TraderCmdSender {
+ public:
+  bool init(const ProtocolQueryCenter* proto) {
+    queue_ =
+        attach_shm_object<TraderCmdQueue>(&shm_, proto->trader_cmd_shm_name());
+    return queue_ != nullptr;
+  }
+
+  /*
+   * 队列满时说明引擎处理不过来或已经退出，短暂自旋后仍失败则放弃
+   */
+  bool send(const TraderCommand* cmd) override {
+    if (cmd->type == NEW_ORDER_BATCH) return send_batch(cmd);
+
+    for (int i = 0; i < kMaxSpins; ++i) {
+      if (queue_->try_push(*cmd)) return true;
+      cpu_relax();
+    }
+    return false;
+  }
+
+ private:
+  bool send_batch(const TraderCommand* cmd) {
+    if (trader_cmd_size(cmd) == 0) return false;
+
+    // 放在栈上，多个线程可以同时发送
+    TraderCommand cells[kMaxBatchOrders + 1];
+    uint32_t count = cmd->order_batch.count;
+    auto reqs = batch_order_reqs(cmd);
+    cells[0] = *cmd;
+    for (uint32_t i = 0; i < count; ++i) {
+      cells[i + 1] = *cmd;
+      cells[i + 1].order_req = reqs[i];
+    }
+
+    for (int i = 0; i < kMaxSpins; ++i) {
+      if (queue_->try_push_n(cells, count + 1)) return true;
+      cpu_relax();
+    }
+    return false;
+  }
+
+ private:
+  static constexpr int kMaxSpins = 1 << 20;
+
+  SharedMemory shm_;
+  TraderCmdQueue* queue_ = nullptr;
+};
+
+class ShmTraderCmdReceiver : public TraderCmdReceiver {
+ public:
+  explicit ShmTraderCmdReceiver(bool futex_wait) : futex_wait_(futex_wait) {}
+
+  /*
+   * 引擎是唯一的读者，启动时丢弃引擎停止期间策略写入的指令，不能在
+   * 很久之后才执行。已连接的策略可能仍在写入，所以只能逐条读出丢弃，
+   * 不能重新初始化队列，这些策略也不需要重启。不存在或布局不同(如旧版本
+   * 留下的)的队列则删除后重新创建
+   */
+  bool init(const ProtocolQueryCenter* proto) {
+    const auto& name = proto->trader_cmd_shm_name();
+    if (shm_.open(name, sizeof(TraderCmdQueue))) {
+      queue_ = reinterpret_cast<TraderCmdQueue*>(shm_.data());
+      if (queue_->is_ready()) {
+        uint64_t dropped = drain();
+        if (dropped > 0)
+          spdlog::warn("[ShmTraderCmdReceiver::init] Dropped {} stale cmds",
+                       dropped);
+        return true;
+      }
+      shm_.close();
+    }
+
+    SharedMemory::unlink(name);
+    queue_ = attach_shm_object<TraderCmdQueue>(&shm_, name);
+    return queue_ != nullptr;
+  }
+
+  const TraderCommand* get_cmd() override {
+    if (queue_->try_pop(&buf_.cmd)) {
+      if (buf_.cmd.type != NEW_ORDER_BATCH) return &buf_.cmd;
+      return recv_batch();
+    }
+
+    if (futex_wait_)
+      queue_->wait(kWaitTimeoutMs);
+    else
+      cpu_relax();
+    return nullptr;
+  }
+
+ private:
+  /*
+   * 读出并丢弃队列中已有的指令，返回丢弃的指令数
+   */
+  uint64_t drain() {
+    uint64_t count = 0;
+    while (queue_->try_pop(&buf_.cmd)) {
+      ++count;
+      if (buf_.cmd.type == NEW_ORDER_BATCH) recv_batch();
+    }
+    return count;
+  }
+
+  /*
+   * 批量报单的后续槽位已被写者预留，很快就会写入，自旋等待即可
+   */
+  const TraderCommand* recv_batch() {
+    uint32_t count = buf_.cmd.order_batch.count;
+    if (trader_cmd_size(&buf_.cmd) == 0) {
+      spdlog::error("[ShmTraderCmdReceiver::get_cmd] Invalid batch size {}",
+                    count);
+      return nullptr;
+    }
+
+    TraderCommand cell;
+    for (uint32_t i = 0; i < count; ++i) {
+      while (!queue_->try_pop(&cell)) cpu_relax();
+      buf_.order_reqs[i] = cell.order_req;
+    }
+    return &buf_.cmd;
+  }
+
+ private:
+  static constexpr uint64_t kWaitTimeoutMs = 100;
+
+  SharedMemory shm_;
+  TraderCmdQueue* queue_ = nullptr;
+  bool futex_wait_;
+  TraderCmdBuffer buf_{};
+};
+
+inline std::unique_ptr<TraderCmdSender> create_trader_cmd_sender(
+    const std::string& transport, const ProtocolQueryCenter* proto) {
+  if (transport == IPC_REDIS)
+    return std::make_unique<RedisTraderCmdSender>(proto);
+
+  if (transport == IPC_SHM) {
+    auto sender = std::make_unique<ShmTraderCmdSender>();
+    if (!sender->init(proto)) {
+      spdlog::error("[create_trader_cmd_sender] Failed to open {}",
+                    proto->trader_cmd_shm_name());
+      return nullptr;
+    }
+    return sender;
+  }
+
+  spdlog::error("[create_trader_cmd_sender] Unknown transport: {}", transport);
+  return nullptr;
+}
+
+inline std::unique_ptr<TraderCmdReceiver> create_trader_cmd_receiver(
+    const std::string& transport, bool futex_wait,
+    const ProtocolQueryCenter* proto) {
+  if (transport == IPC_REDIS)
+    return std::make_unique<RedisTraderCmdReceiver>(proto);
+
+  if (transport == IPC_SHM) {
+    auto receiver = std::make_unique<ShmTraderCmdReceiver>(futex_wait);
+    if (!receiver->init(proto)) {
+      spdlog::error("[create_trader_cmd_receiver] Failed to open {}",
+                    proto->trader_cmd_shm_name());
+      return nullptr;
+    }
+    return receiver;
+  }
+
+  spdlog::error("[create_trader_cmd_receiver] Unknown transport: {}",
+                transport);
+  return nullptr;
+}
+
+}  // namespace ft
+
+#endif  // FT_SRC_COMMON_TRADERCMDTRANSPORT_H_
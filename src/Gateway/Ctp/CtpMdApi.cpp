@@ -6,6 +6,8 @@
 
 #include <utility>
 
+#include "Common/Metrics.h"
+
 namespace ft {
 
 CtpMdApi::CtpMdApi(TradingEngineInterface *engine) : engine_(engine) {}
@@ -129,6 +131,7 @@ void CtpMdApi::OnRspUserLogout(CThostFtdcUserLogoutField *logout_rsp,
 
 void CtpMdApi::OnRspError(CThostFtdcRspInfoField *rsp_info, int req_id,
                           bool is_last) {
+  Metrics::add(MC_GATEWAY_ERROR);
   spdlog::debug("[CtpMdApi::OnRspError] ErrorMsg: {}",
                 gb2312_to_utf8(rsp_info->ErrorMsg));
   is_logon_ = false;
@@ -169,6 +172,8 @@ void CtpMdApi::OnRspUnSubForQuoteRsp(
     CThostFtdcRspInfoField *rsp_info, int req_id, bool is_last) {}
 
 void CtpMdApi::OnRtnDepthMarketData(CThostFtdcDepthMarketDataField *md) {
+  Metrics::add(MC_GATEWAY_TICK);
+
   if (!md) {
     spdlog::error("[CtpMdApi::OnRtnDepthMarketData] Failed. md is nullptr");
     return;
@@ -5,6 +5,7 @@
 #include <ThostFtdcTraderApi.h>
 #include <spdlog/spdlog.h>
 
+#include "Common/Metrics.h"
 #include "Utils/Misc.h"
 
 namespace ft {
@@ -321,6 +322,8 @@ uint64_t CtpTradeApi::send_order(const OrderReq *order) {
 void CtpTradeApi::OnRspOrderInsert(CThostFtdcInputOrderField *order,
                                    CThostFtdcRspInfoField *rsp_info, int req_id,
                                    bool is_last) {
+  Metrics::add(MC_GATEWAY_ERROR);
+
   if (!order) {
     spdlog::warn("[CtpTradeApi::OnRspOrderInsert] nullptr");
     return;
@@ -361,6 +364,8 @@ void CtpTradeApi::OnRspOrderInsert(CThostFtdcInputOrderField *order,
 }
 
 void CtpTradeApi::OnRtnOrder(CThostFtdcOrderField *order) {
+  Metrics::add(MC_GATEWAY_ORDER_RSP);
+
   if (!order) {
     spdlog::warn("[CtpTradeApi::OnRtnOrder] nullptr");
     return;
@@ -435,6 +440,8 @@ void CtpTradeApi::OnRtnOrder(CThostFtdcOrderField *order) {
 }
 
 void CtpTradeApi::OnRtnTrade(CThostFtdcTradeField *trade) {
+  Metrics::add(MC_GATEWAY_ORDER_RSP);
+
   if (!trade) {
     spdlog::warn("[CtpTradeApi::OnRtnTrade] nullptr");
     return;
@@ -501,6 +508,8 @@ bool CtpTradeApi::cancel_order(uint64_t order_id) {
 void CtpTradeApi::OnRspOrderAction(CThostFtdcInputOrderActionField *action,
                                    CThostFtdcRspInfoField *rsp_info, int req_id,
                                    bool is_last) {
+  Metrics::add(MC_GATEWAY_ERROR);
+
   if (!action) {
     spdlog::warn("[CtpTradeApi::OnRspOrderAction] nullptr");
   }
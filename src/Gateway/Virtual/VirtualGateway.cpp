@@ -4,6 +4,7 @@
 
 #include <spdlog/spdlog.h>
 
+#include "Common/Metrics.h"
 #include "Core/ContractTable.h"
 
 namespace ft {
@@ -68,18 +69,24 @@ bool VirtualGateway::query_commision_rate(const std::string& ticker) {
 }
 
 void VirtualGateway::on_order_accepted(uint64_t order_id) {
+  Metrics::add(MC_GATEWAY_ORDER_RSP);
   engine_->on_order_accepted(order_id);
 }
 
 void VirtualGateway::on_order_traded(uint64_t order_id, int traded,
                                      double price) {
+  Metrics::add(MC_GATEWAY_ORDER_RSP);
   engine_->on_order_traded(order_id, traded, price);
 }
 
 void VirtualGateway::on_order_canceled(uint64_t order_id, int canceled) {
+  Metrics::add(MC_GATEWAY_ORDER_RSP);
   engine_->on_order_canceled(order_id, canceled);
 }
 
-void VirtualGateway::on_tick(const TickData* tick) { engine_->on_tick(tick); }
+void VirtualGateway::on_tick(const TickData* tick) {
+  Metrics::add(MC_GATEWAY_TICK);
+  engine_->on_tick(tick);
+}
 
 }  // namespace ft
@@ -38,6 +38,11 @@ uint64_t XtpGateway::send_order(const OrderReq* order) {
   return trade_api_->send_order(order);
 }
 
+void XtpGateway::send_order_batch(const OrderReq* orders, std::size_t count,
+                                  uint64_t* order_ids) {
+  trade_api_->send_order_batch(orders, count, order_ids);
+}
+
 bool XtpGateway::cancel_order(uint64_t order_id) {
   return trade_api_->cancel_order(order_id);
 }
@@ -26,6 +26,9 @@ class XtpGateway : public Gateway {
 
   uint64_t send_order(const OrderReq* order) override;
 
+  void send_order_batch(const OrderReq* orders, std::size_t count,
+                        uint64_t* order_ids) override;
+
   bool cancel_order(uint64_t order_id) override;
 
   bool query_contract(const std::string& ticker,
@@ -6,6 +6,7 @@
 
 #include <vector>
 
+#include "Common/Metrics.h"
 #include "Core/ContractTable.h"
 
 namespace ft {
@@ -161,6 +162,8 @@ void XtpMdApi::OnDepthMarketData(XTPMD* market_data, int64_t bid1_qty[],
                                  int32_t bid1_count, int32_t max_bid1_count,
                                  int64_t ask1_qty[], int32_t ask1_count,
                                  int32_t max_ask1_count) {
+  Metrics::add(MC_GATEWAY_TICK);
+
   if (!market_data) {
     spdlog::warn("[XtpMdApi::OnDepthMarketData] nullptr");
     return;
@@ -6,6 +6,7 @@
 
 #include <cstdlib>
 
+#include "Common/Metrics.h"
 #include "Core/ContractTable.h"
 #include "Utils/Misc.h"
 
@@ -81,46 +82,89 @@ void XtpTradeApi::logout() {
 uint64_t XtpTradeApi::send_order(const OrderReq* order) {
   if (session_id_ == 0) {
     spdlog::error("[XtpTradeApi::send_order] Not logon");
-    return false;
+    return 0;
+  }
+
+  XTPOrderInsertInfo req{};
+  const Contract* contract;
+  if (!fill_order_insert_info(order, &req, &contract)) return 0;
+
+  std::unique_lock<std::mutex> lock(order_mutex_);
+  return insert_order(&req, contract);
+}
+
+/*
+ * XTP没有批量报单接口，先完成所有订单的转换，再在一次加锁内连续调用
+ * InsertOrder，尽量缩短整批订单发出的时间
+ */
+void XtpTradeApi::send_order_batch(const OrderReq* orders, std::size_t count,
+                                   uint64_t* order_ids) {
+  for (std::size_t i = 0; i < count; ++i) order_ids[i] = 0;
+  if (session_id_ == 0) {
+    spdlog::error("[XtpTradeApi::send_order_batch] Not logon");
+    return;
+  }
+
+  XTPOrderInsertInfo reqs[kMaxBatchOrders];
+  const Contract* contracts[kMaxBatchOrders];
+  bool valid[kMaxBatchOrders];
+  if (count > kMaxBatchOrders) count = kMaxBatchOrders;
+  for (std::size_t i = 0; i < count; ++i) {
+    reqs[i] = XTPOrderInsertInfo{};
+    valid[i] = fill_order_insert_info(&orders[i], &reqs[i], &contracts[i]);
   }
 
-  auto contract = ContractTable::get_by_index(order->ticker_index);
-  if (!contract) {
+  std::unique_lock<std::mutex> lock(order_mutex_);
+  for (std::size_t i = 0; i < count; ++i) {
+    if (valid[i]) order_ids[i] = insert_order(&reqs[i], contracts[i]);
+  }
+}
+
+bool XtpTradeApi::fill_order_insert_info(const OrderReq* order,
+                                         XTPOrderInsertInfo* req,
+                                         const Contract** contract) {
+  *contract = ContractTable::get_by_index(order->ticker_index);
+  if (!*contract) {
     spdlog::error("[XtpTradeApi::send_order] Contract not found");
     return false;
   }
 
-  XTPOrderInsertInfo req{};
-  req.side = xtp_side(order->direction);
-  if (req.side == XTP_SIDE_UNKNOWN) {
+  req->side = xtp_side(order->direction);
+  if (req->side == XTP_SIDE_UNKNOWN) {
     spdlog::error("[XtpTradeApi::send_order] 不支持的交易类型");
     return false;
   }
 
-  req.price_type = xtp_price_type(order->type);
-  if (req.side == XTP_PRICE_TYPE_UNKNOWN) {
+  req->price_type = xtp_price_type(order->type);
+  if (req->side == XTP_PRICE_TYPE_UNKNOWN) {
     spdlog::error("[XtpTradeApi::send_order] 不支持的订单价格类型");
     return false;
   }
 
-  req.market = xtp_market_type(contract->exchange);
-  if (req.market == XTP_MKT_UNKNOWN) {
+  req->market = xtp_market_type((*contract)->exchange);
+  if (req->market == XTP_MKT_UNKNOWN) {
     spdlog::error("[XtpTradeApi::send_order] Unknown exchange");
     return false;
   }
 
-  req.order_client_id = next_client_order_id();
-  strncpy(req.ticker, contract->ticker.c_str(), sizeof(req.ticker));
-  req.price = order->price;
-  req.quantity = order->volume;
-  req.business_type = XTP_BUSINESS_TYPE_CASH;
+  req->order_client_id = next_client_order_id();
+  strncpy(req->ticker, (*contract)->ticker.c_str(), sizeof(req->ticker));
+  req->price = order->price;
+  req->quantity = order->volume;
+  req->business_type = XTP_BUSINESS_TYPE_CASH;
+  return true;
+}
 
-  std::unique_lock<std::mutex> lock(order_mutex_);
-  uint64_t xtp_order_id = trade_api_->InsertOrder(&req, session_id_);
+/*
+ * 调用者须持有order_mutex_
+ */
+uint64_t XtpTradeApi::insert_order(XTPOrderInsertInfo* req,
+                                   const Contract* contract) {
+  uint64_t xtp_order_id = trade_api_->InsertOrder(req, session_id_);
   if (xtp_order_id == 0) {
     spdlog::error("[XtpTradeApi::send_order] 订单插入失败: {}",
                   trade_api_->GetApiLastError()->error_msg);
-    return false;
+    return 0;
   }
 
   spdlog::debug("[XtpTradeApi::send_order] 订单插入成功. XtpOrderID: {}",
@@ -128,7 +172,7 @@ uint64_t XtpTradeApi::send_order(const OrderReq* order) {
 
   OrderDetail detail{};
   detail.contract = contract;
-  detail.original_vol = order->volume;
+  detail.original_vol = req->quantity;
   order_details_.emplace(xtp_order_id, detail);
 
   return xtp_order_id;
@@ -138,6 +182,8 @@ void XtpTradeApi::OnOrderEvent(XTPOrderInfo* order_info, XTPRI* error_info,
                                uint64_t session_id) {
   if (session_id != session_id_) return;
 
+  Metrics::add(MC_GATEWAY_ORDER_RSP);
+
   if (!order_info) {
     spdlog::warn("[XtpTradeApi::OnOrderEvent] nullptr");
     return;
@@ -167,6 +213,7 @@ void XtpTradeApi::OnOrderEvent(XTPOrderInfo* order_info, XTPRI* error_info,
   auto& detail = iter->second;
 
   if (is_error_rsp(error_info)) {
+    Metrics::add(MC_GATEWAY_ERROR);
     spdlog::error("[XtpTradeApi::OnOrderEvent] ErrorMsg: {}",
                   error_info->error_msg);
     engine_->on_order_rejected(order_info->order_xtp_id);
@@ -202,6 +249,8 @@ void XtpTradeApi::OnTradeEvent(XTPTradeReport* trade_info,
                                uint64_t session_id) {
   if (session_id_ != session_id) return;
 
+  Metrics::add(MC_GATEWAY_ORDER_RSP);
+
   if (!trade_info) {
     spdlog::warn("[XtpTradeApi::OnTradeEvent] nullptr");
     return;
@@ -256,6 +305,8 @@ void XtpTradeApi::OnCancelOrderError(XTPOrderCancelInfo* cancel_info,
 
   if (!is_error_rsp(error_info)) return;
 
+  Metrics::add(MC_GATEWAY_ERROR);
+
   if (!cancel_info) {
     spdlog::warn("[XtpTradeApi::OnCancelOrderError] nullptr");
     return;
@@ -31,6 +31,9 @@ class XtpTradeApi : public XTP::API::TraderSpi {
 
   uint64_t send_order(const OrderReq* order);
 
+  void send_order_batch(const OrderReq* orders, std::size_t count,
+                        uint64_t* order_ids);
+
   bool cancel_order(uint64_t order_id);
 
   bool query_position(const std::string& ticker);
@@ -67,6 +70,11 @@ class XtpTradeApi : public XTP::API::TraderSpi {
  private:
   uint32_t next_client_order_id() { return next_client_order_id_++; }
 
+  bool fill_order_insert_info(const OrderReq* order, XTPOrderInsertInfo* req,
+                              const Contract** contract);
+
+  uint64_t insert_order(XTPOrderInsertInfo* req, const Contract* contract);
+
   int next_req_id() { return next_req_id_++; }
 
   void done() { is_done_ = true; }
@@ -2,34 +2,42 @@
 
 #include "RiskManagement/AvailableFundCheck.h"
 
+#include <spdlog/spdlog.h>
+
 #include "Core/Constants.h"
 #include "Core/ContractTable.h"
 
 namespace ft {
 
-AvailableFundCheck::AvailableFundCheck(const Account* account)
-    : account_(account) {}
+AvailableFundCheck::AvailableFundCheck(const AccountLedger* ledger)
+    : ledger_(ledger) {}
 
 int AvailableFundCheck::check_order_req(const OrderReq* order) {
-  if (is_offset_close(order->offset)) return NO_ERROR;
+  if (!is_offset_open(order->offset)) return NO_ERROR;
 
   auto contract = ContractTable::get_by_index(order->ticker_index);
   assert(contract);
   assert(contract->size > 0);
 
-  double avl = account_->balance - account_->frozen - account_->margin;
-  double estimated;
-  if (order->direction == Direction::BUY) {
-    estimated = order->price * order->volume * contract->size *
-                contract->long_margin_rate;
-  } else if (order->direction == Direction::SELL) {
-    estimated = order->price * order->volume * contract->size *
-                contract->short_margin_rate;
-  } else {
-    assert(false);
+  double price =
+      ledger_->margin_price(order->ticker_index, order->type, order->price);
+  if (price <= 0) {
+    spdlog::error(
+        "[AvailableFundCheck::check] No reference price. Ticker: {}",
+        contract->ticker);
+    return ERR_FUND_NOT_ENOUGH;
   }
 
-  if (avl < estimated) return ERR_FUND_NOT_ENOUGH;
+  double estimated = AccountLedger::margin_of(contract, order->direction,
+                                              order->volume, price);
+  double avl = ledger_->available();
+  if (avl < estimated) {
+    spdlog::error(
+        "[AvailableFundCheck::check] Fund not enough. Available: {:.2f}, "
+        "Required: {:.2f}",
+        avl, estimated);
+    return ERR_FUND_NOT_ENOUGH;
+  }
 
   return NO_ERROR;
 }
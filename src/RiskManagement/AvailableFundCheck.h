@@ -3,27 +3,21 @@
 #ifndef FT_SRC_RISKMANAGEMENT_AVAILABLEFUNDCHECK_H_
 #define FT_SRC_RISKMANAGEMENT_AVAILABLEFUNDCHECK_H_
 
-#include <spdlog/spdlog.h>
-
-#include <string>
-#include <vector>
-
-#include "Core/Account.h"
+#include "Common/AccountLedger.h"
 #include "RiskManagement/RiskRuleInterface.h"
 
 namespace ft {
 
-// 拦截自成交订单，检查相反方向的挂单
-// 1. 市价单
-// 2. 非市价单的其他订单，且价格可以成功撮合的
-class AvailableFundCheck : public RiskRuleInterface {
+// 检查开仓单所需的保证金是否超过可用资金，平仓单不检查。市价单按最新价
+// 估算，还没有行情时无法估算，拒单
+class AvailableFundCheck final : public RiskRuleInterface {
  public:
-  explicit AvailableFundCheck(const Account* account);
+  explicit AvailableFundCheck(const AccountLedger* ledger);
 
   int check_order_req(const OrderReq* order) override;
 
  private:
-  const Account* account_{nullptr};
+  const AccountLedger* ledger_{nullptr};
 };
 
 }  // namespace ft
@@ -16,7 +16,7 @@ namespace ft {
 // 拦截自成交订单，检查相反方向的挂单
 // 1. 市价单
 // 2. 非市价单的其他订单，且价格可以成功撮合的
-class AvailablePosCheck : public RiskRuleInterface {
+class AvailablePosCheck final : public RiskRuleInterface {
  public:
   explicit AvailablePosCheck(const PositionManager* pos_mgr);
 
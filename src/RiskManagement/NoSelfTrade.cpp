@@ -6,49 +6,125 @@
 
 namespace ft {
 
+NoSelfTradeRule::NoSelfTradeRule()
+    : books_(ContractTable::size() + 1),
+      id_slots_(std::make_unique<IdSlot[]>(kIdSlots)) {}
+
 int NoSelfTradeRule::check_order_req(const OrderReq* order) {
   const auto* contract = ContractTable::get_by_index(order->ticker_index);
   assert(contract);
 
-  uint64_t opp_d = opp_direction(order->direction);  // 对手方
-  const OrderReq* pending_order;
-  for (auto& o : orders_) {
-    pending_order = &o;
-    if (pending_order->direction != opp_d) continue;
+  if (order->ticker_index >= books_.size())
+    books_.resize(order->ticker_index + 1);
 
-    // 存在市价单直接拒绝
-    if (pending_order->type == OrderType::MARKET) goto catch_order;
+  bool is_bid = order->direction == Direction::BUY;
+  // BEST单与市价单一样没有报单价，可能与对手方向的任何挂单成交
+  bool is_market =
+      order->type == OrderType::MARKET || order->type == OrderType::BEST;
+  auto& opp = side_of(order->ticker_index, opp_direction(order->direction));
 
-    if (order->direction == Direction::BUY) {
-      if (order->price > pending_order->price - 1e-5) goto catch_order;
-    } else {
-      if (order->price < pending_order->price + 1e-5) goto catch_order;
-    }
+  // 存在市价单，或本订单为市价单且对手方向有挂单时直接拒绝
+  bool self_trade = opp.market_count > 0;
+  if (!self_trade && opp.limit_count > 0) {
+    if (is_market)
+      self_trade = true;
+    else if (is_bid)
+      self_trade = order->price > opp.best_price - 1e-5;
+    else
+      self_trade = order->price < opp.best_price + 1e-5;
   }
 
-  orders_.emplace_back(*order);
-  return NO_ERROR;
+  if (self_trade) {
+    spdlog::error(
+        "[RiskMgr] Self trade! Ticker: {}. This Order: "
+        "[Direction: {}, Type: {}, Price: {:.2f}]. "
+        "Pending Orders: [Direction: {}, Market: {}, Limit: {}, "
+        "BestPrice: {:.2f}]",
+        contract->ticker, direction_str(order->direction),
+        ordertype_str(order->type), order->price,
+        direction_str(opp_direction(order->direction)), opp.market_count,
+        opp.limit_count, opp.best_price);
+    return ERR_SELF_TRADE;
+  }
+
+  auto& side = side_of(order->ticker_index, order->direction);
+  side.orders.emplace_back(
+      Resting{order->engine_order_id, order->price, is_market});
+  if (is_market) {
+    ++side.market_count;
+  } else {
+    if (side.limit_count == 0 ||
+        (is_bid ? order->price > side.best_price
+                : order->price < side.best_price))
+      side.best_price = order->price;
+    ++side.limit_count;
+  }
 
-catch_order:
-  spdlog::error(
-      "[RiskMgr] Self trade! Ticker: {}. This Order: "
-      "[Direction: {}, Type: {}, Price: {:.2f}]. "
-      "Pending Order: [Direction: {}, Type: {}, Price: {:.2f}]",
-      contract->ticker, direction_str(order->direction),
-      ordertype_str(order->type), order->price,
-      direction_str(pending_order->direction),
-      ordertype_str(pending_order->type), pending_order->price);
-  return ERR_SELF_TRADE;
+  auto& slot = id_slots_[order->engine_order_id & (kIdSlots - 1)];
+  if (slot.engine_order_id != 0) ++evicted_;
+  slot.engine_order_id = order->engine_order_id;
+  slot.ticker_index = order->ticker_index;
+  return NO_ERROR;
 }
 
 void NoSelfTradeRule::on_order_completed(uint64_t engine_order_id,
                                          int error_code) {
-  for (auto iter = orders_.begin(); iter != orders_.end(); ++iter) {
-    if (iter->engine_order_id == engine_order_id) {
-      orders_.erase(iter);
+  auto& slot = id_slots_[engine_order_id & (kIdSlots - 1)];
+  if (slot.engine_order_id == engine_order_id) {
+    slot.engine_order_id = 0;
+    if (slot.ticker_index < books_.size())
+      erase_from(&books_[slot.ticker_index], engine_order_id);
+    return;
+  }
+
+  // 没有通过本规则检查的订单直接忽略；只有存在槽位被覆盖的挂单时才
+  // 需要扫描所有合约，这种情况很少出现
+  if (evicted_ == 0) return;
+  for (auto& book : books_) {
+    if (erase_from(&book, engine_order_id)) {
+      --evicted_;
       return;
     }
   }
 }
 
+bool NoSelfTradeRule::erase_from(Book* book, uint64_t engine_order_id) {
+  return erase_from(&book->bid, true, engine_order_id) ||
+         erase_from(&book->ask, false, engine_order_id);
+}
+
+bool NoSelfTradeRule::erase_from(Side* side, bool is_bid,
+                                 uint64_t engine_order_id) {
+  auto& orders = side->orders;
+  for (std::size_t i = 0; i < orders.size(); ++i) {
+    if (orders[i].engine_order_id != engine_order_id) continue;
+
+    bool is_market = orders[i].is_market;
+    double price = orders[i].price;
+    orders[i] = orders.back();
+    orders.pop_back();
+
+    if (is_market) {
+      --side->market_count;
+      return true;
+    }
+
+    --side->limit_count;
+    if (side->limit_count == 0 || price != side->best_price) return true;
+
+    // 移除的是最优价的挂单，重新计算该方向的最优价
+    bool first = true;
+    for (const auto& o : orders) {
+      if (o.is_market) continue;
+      if (first || (is_bid ? o.price > side->best_price
+                           : o.price < side->best_price)) {
+        side->best_price = o.price;
+        first = false;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
 }  // namespace ft
@@ -5,24 +5,71 @@
 
 #include <spdlog/spdlog.h>
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "Core/Constants.h"
 #include "RiskManagement/RiskRuleInterface.h"
 
 namespace ft {
 
-// 拦截自成交订单，检查相反方向的挂单
-// 1. 市价单
+// 拦截自成交订单，检查同一合约相反方向的挂单
+// 1. 市价单，或本订单为市价单且对手方向有挂单
 // 2. 非市价单的其他订单，且价格可以成功撮合的
-class NoSelfTradeRule : public RiskRuleInterface {
+//
+// 每个合约的每个方向维护本账户挂单的最优价(买方向的最高价、卖方向的
+// 最低价)及市价单数量，检查只需与对手方向的最优价比较。挂单完成时只
+// 重新计算该合约该方向的最优价
+class NoSelfTradeRule final : public RiskRuleInterface {
  public:
+  NoSelfTradeRule();
+
   int check_order_req(const OrderReq* order) override;
 
   void on_order_completed(uint64_t order_id, int error_code) override;
 
  private:
-  std::vector<OrderReq> orders_;
+  struct Resting {
+    uint64_t engine_order_id;
+    double price;
+    bool is_market;  // 市价单或BEST单，没有报单价
+  };
+
+  struct Side {
+    std::vector<Resting> orders;
+    double best_price = 0;  // 限价挂单的最优价，没有限价挂单时无意义
+    uint32_t limit_count = 0;
+    uint32_t market_count = 0;
+  };
+
+  struct Book {
+    Side bid;
+    Side ask;
+  };
+
+  // 以engine_order_id的低位为下标记录订单所属的合约。槽位被更新的订单
+  // 覆盖时，原订单完成时需要扫描所有合约
+  struct IdSlot {
+    uint64_t engine_order_id = 0;
+    uint32_t ticker_index = 0;
+  };
+
+  static constexpr uint64_t kIdSlots = 1 << 17;
+
+  Side& side_of(uint32_t ticker_index, uint32_t direction) {
+    auto& book = books_[ticker_index];
+    return direction == Direction::BUY ? book.bid : book.ask;
+  }
+
+  bool erase_from(Book* book, uint64_t engine_order_id);
+
+  static bool erase_from(Side* side, bool is_bid, uint64_t engine_order_id);
+
+ private:
+  std::vector<Book> books_;  // 下标为ticker_index
+  std::unique_ptr<IdSlot[]> id_slots_;
+  uint64_t evicted_ = 0;  // 槽位被覆盖且还未完成的挂单数
 };
 
 }  // namespace ft
@@ -0,0 +1,148 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "RiskManagement/PriceLimitRule.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "Core/Constants.h"
+#include "Core/ContractTable.h"
+
+namespace ft {
+
+PriceLimitRule::PriceLimitRule(const Config& config)
+    : price_band_ticks_(config.price_band_ticks),
+      max_order_notional_(config.max_order_notional),
+      max_ticker_notional_(config.max_ticker_notional),
+      prices_(std::make_unique<PriceCache[]>(ContractTable::size() + 1)),
+      price_count_(ContractTable::size() + 1) {
+  if (max_ticker_notional_ > 0) {
+    ticker_notional_.resize(ContractTable::size() + 1, 0);
+    id_slots_ = std::make_unique<IdSlot[]>(kIdSlots);
+  }
+}
+
+void PriceLimitRule::on_tick(const TickData* tick) {
+  if (tick->ticker_index >= price_count_) return;
+
+  auto& cache = prices_[tick->ticker_index];
+  if (tick->upper_limit_price > 0)
+    cache.upper_limit.store(tick->upper_limit_price,
+                            std::memory_order_relaxed);
+  if (tick->lower_limit_price > 0)
+    cache.lower_limit.store(tick->lower_limit_price,
+                            std::memory_order_relaxed);
+  if (tick->last_price > 0)
+    cache.last_price.store(tick->last_price, std::memory_order_relaxed);
+}
+
+int PriceLimitRule::check_order_req(const OrderReq* order) {
+  const auto* contract = ContractTable::get_by_index(order->ticker_index);
+  assert(contract);
+  if (order->ticker_index >= price_count_) return NO_ERROR;
+
+  const auto& cache = prices_[order->ticker_index];
+  double last_price = cache.last_price.load(std::memory_order_relaxed);
+  bool is_priced =
+      order->type != OrderType::MARKET && order->type != OrderType::BEST;
+
+  if (is_priced) {
+    double eps = contract->price_tick * 1e-3;
+    double upper = cache.upper_limit.load(std::memory_order_relaxed);
+    double lower = cache.lower_limit.load(std::memory_order_relaxed);
+    if ((upper > 0 && order->price > upper + eps) ||
+        (lower > 0 && order->price < lower - eps)) {
+      spdlog::error(
+          "[PriceLimitRule::check] Price out of limit. Ticker: {}, "
+          "Price: {:.3f}, Lower: {:.3f}, Upper: {:.3f}",
+          contract->ticker, order->price, lower, upper);
+      return ERR_PRICE_LIMIT;
+    }
+
+    if (price_band_ticks_ > 0 && last_price > 0 &&
+        std::fabs(order->price - last_price) >
+            price_band_ticks_ * contract->price_tick + eps) {
+      spdlog::error(
+          "[PriceLimitRule::check] Price deviates too far. Ticker: {}, "
+          "Price: {:.3f}, LastPrice: {:.3f}, MaxTicks: {}",
+          contract->ticker, order->price, last_price, price_band_ticks_);
+      return ERR_PRICE_DEVIATION;
+    }
+  }
+
+  if (max_order_notional_ <= 0 && max_ticker_notional_ <= 0) return NO_ERROR;
+
+  double ref_price = order->price;
+  if (!is_priced) {
+    ref_price = last_price > 0
+                    ? last_price
+                    : cache.upper_limit.load(std::memory_order_relaxed);
+    if (ref_price <= 0) {
+      spdlog::error(
+          "[PriceLimitRule::check] No price to value market order. "
+          "Ticker: {}",
+          contract->ticker);
+      return ERR_NOTIONAL_LIMIT;
+    }
+  }
+  double lot_notional = ref_price * contract->size;
+  double notional = lot_notional * order->volume;
+  if (max_order_notional_ > 0 && notional > max_order_notional_) {
+    spdlog::error(
+        "[PriceLimitRule::check] Order notional reached limit. Ticker: {}, "
+        "Notional: {:.2f}, Limit: {:.2f}",
+        contract->ticker, notional, max_order_notional_);
+    return ERR_NOTIONAL_LIMIT;
+  }
+
+  if (max_ticker_notional_ > 0) {
+    auto& ticker_notional = ticker_notional_[order->ticker_index];
+    if (ticker_notional + notional > max_ticker_notional_) {
+      spdlog::error(
+          "[PriceLimitRule::check] Ticker notional reached limit. Ticker: {}, "
+          "Pending: {:.2f}, This Order: {:.2f}, Limit: {:.2f}",
+          contract->ticker, ticker_notional, notional, max_ticker_notional_);
+      return ERR_NOTIONAL_LIMIT;
+    }
+
+    auto& slot = id_slots_[order->engine_order_id & (kIdSlots - 1)];
+    if (slot.engine_order_id != 0) release(&slot, slot.volume);
+    slot.engine_order_id = order->engine_order_id;
+    slot.ticker_index = order->ticker_index;
+    slot.volume = order->volume;
+    slot.lot_notional = lot_notional;
+    ticker_notional += notional;
+  }
+
+  return NO_ERROR;
+}
+
+void PriceLimitRule::on_order_traded(uint64_t engine_order_id,
+                                     int this_traded, double traded_price) {
+  if (!id_slots_) return;
+
+  auto& slot = id_slots_[engine_order_id & (kIdSlots - 1)];
+  if (slot.engine_order_id == engine_order_id) release(&slot, this_traded);
+}
+
+void PriceLimitRule::on_order_completed(uint64_t engine_order_id,
+                                        int error_code) {
+  if (!id_slots_) return;
+
+  auto& slot = id_slots_[engine_order_id & (kIdSlots - 1)];
+  if (slot.engine_order_id != engine_order_id) return;
+  release(&slot, slot.volume);
+  slot.engine_order_id = 0;
+}
+
+void PriceLimitRule::release(IdSlot* slot, int volume) {
+  volume = std::min(volume, slot->volume);
+  auto& ticker_notional = ticker_notional_[slot->ticker_index];
+  ticker_notional -= slot->lot_notional * volume;
+  if (ticker_notional < 0) ticker_notional = 0;
+  slot->volume -= volume;
+}
+
+}  // namespace ft
@@ -0,0 +1,76 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_RISKMANAGEMENT_PRICELIMITRULE_H_
+#define FT_SRC_RISKMANAGEMENT_PRICELIMITRULE_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Core/Config.h"
+#include "Core/TickData.h"
+#include "RiskManagement/RiskRuleInterface.h"
+
+namespace ft {
+
+/*
+ * 价格及名义金额检查，在本地拒绝明显错误的订单，不必等柜台或交易所拒单
+ *
+ * 1. 限价单的价格超出涨跌停板
+ * 2. 限价单的价格偏离最新价超过price_band_ticks跳
+ * 3. 单笔订单的名义金额超过max_order_notional
+ * 4. 同一合约所有未成交订单的名义金额合计超过max_ticker_notional
+ *
+ * 涨跌停板和最新价由on_tick在行情线程中写入，其余回调都在引擎线程中。
+ * 还没有收到过行情的合约不做价格检查。市价单按最新价估算名义金额，没有
+ * 最新价时按涨停价估算，都没有时若设置了名义金额限制则拒单
+ */
+class PriceLimitRule final : public RiskRuleInterface {
+ public:
+  explicit PriceLimitRule(const Config& config);
+
+  void on_tick(const TickData* tick);
+
+  int check_order_req(const OrderReq* order) override;
+
+  void on_order_traded(uint64_t engine_order_id, int this_traded,
+                       double traded_price) override;
+
+  void on_order_completed(uint64_t engine_order_id, int error_code) override;
+
+ private:
+  struct alignas(64) PriceCache {
+    std::atomic<double> upper_limit{0};
+    std::atomic<double> lower_limit{0};
+    std::atomic<double> last_price{0};
+  };
+
+  // 以engine_order_id的低位为下标记录计入合约名义金额的订单。槽位被新订单
+  // 覆盖时提前释放原订单的金额，只会少算不会多算
+  struct IdSlot {
+    uint64_t engine_order_id = 0;
+    uint32_t ticker_index = 0;
+    int volume = 0;           // 未成交的数量
+    double lot_notional = 0;  // 每手的名义金额
+  };
+
+  static constexpr uint64_t kIdSlots = 1 << 17;
+
+  void release(IdSlot* slot, int volume);
+
+ private:
+  uint32_t price_band_ticks_ = 0;
+  double max_order_notional_ = 0;
+  double max_ticker_notional_ = 0;
+
+  std::unique_ptr<PriceCache[]> prices_;  // 下标为ticker_index
+  std::size_t price_count_ = 0;
+
+  // 只在设置了max_ticker_notional时分配
+  std::vector<double> ticker_notional_;
+  std::unique_ptr<IdSlot[]> id_slots_;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_RISKMANAGEMENT_PRICELIMITRULE_H_
@@ -2,46 +2,47 @@
 
 #include "RiskManagement/RiskManager.h"
 
-#include "RiskManagement/AvailablePosCheck.h"
-#include "RiskManagement/NoSelfTrade.h"
-#include "RiskManagement/ThrottleRateLimit.h"
+#include <utility>
+
+#include "Common/Metrics.h"
 
 namespace ft {
 
-RiskManager::RiskManager(const PositionManager* pos_mgr) : pos_mgr_(pos_mgr) {
-  // 先硬编码吧
-  add_rule(std::make_shared<AvailablePosCheck>(pos_mgr));
-  add_rule(std::make_shared<NoSelfTradeRule>());
-  add_rule(std::make_shared<ThrottleRateLimit>(1000, 2, 100));
-}
+RiskManager::RiskManager(const Config& config,
+                         const PositionManager* pos_mgr,
+                         const AccountLedger* ledger,
+                         const StrategyIdTable* strategy_ids)
+    : pos_mgr_(pos_mgr),
+      pipeline_(PriceLimitRule(config), AvailablePosCheck(pos_mgr),
+                AvailableFundCheck(ledger), NoSelfTradeRule(),
+                ThrottleRateLimit(config, strategy_ids), DynamicRuleSet()) {}
 
 void RiskManager::add_rule(std::shared_ptr<RiskRuleInterface> rule) {
-  rules_.emplace_back(rule);
+  pipeline_.get<DynamicRuleSet>().add_rule(std::move(rule));
 }
 
 int RiskManager::check_order_req(const OrderReq* order) {
-  int error_code;
-
-  for (auto& rule : rules_) {
-    error_code = rule->check_order_req(order);
-    if (error_code != NO_ERROR) return error_code;
-  }
-
-  return NO_ERROR;
+  int error_code = pipeline_.check_order_req(order);
+  if (error_code != NO_ERROR) Metrics::add_risk_reject(error_code);
+  return error_code;
 }
 
 void RiskManager::on_order_sent(uint64_t order_id) {
-  for (auto& rule : rules_) rule->on_order_sent(order_id);
+  pipeline_.on_order_sent(order_id);
 }
 
 void RiskManager::on_order_traded(uint64_t order_id, int this_traded,
                                   double traded_price) {
-  for (auto& rule : rules_)
-    rule->on_order_traded(order_id, this_traded, traded_price);
+  pipeline_.on_order_traded(order_id, this_traded, traded_price);
 }
 
 void RiskManager::on_order_completed(uint64_t order_id, int error_code) {
-  for (auto& rule : rules_) rule->on_order_completed(order_id, error_code);
+  pipeline_.on_order_completed(order_id, error_code);
+}
+
+// 只有价格检查需要行情，直接转发，不经过规则链
+void RiskManager::on_tick(const TickData* tick) {
+  pipeline_.get<PriceLimitRule>().on_tick(tick);
 }
 
 }  // namespace ft
@@ -3,21 +3,34 @@
 #ifndef FT_SRC_RISKMANAGEMENT_RISKMANAGER_H_
 #define FT_SRC_RISKMANAGEMENT_RISKMANAGER_H_
 
-#include <list>
 #include <memory>
 #include <string>
 
+#include "Common/AccountLedger.h"
 #include "Common/PositionManager.h"
+#include "Common/StrategyIdTable.h"
+#include "Core/Config.h"
 #include "Core/Gateway.h"
 #include "Core/RiskManagementInterface.h"
+#include "RiskManagement/AvailableFundCheck.h"
+#include "RiskManagement/AvailablePosCheck.h"
+#include "RiskManagement/NoSelfTrade.h"
+#include "RiskManagement/PriceLimitRule.h"
+#include "RiskManagement/RiskPipeline.h"
 #include "RiskManagement/RiskRuleInterface.h"
+#include "RiskManagement/ThrottleRateLimit.h"
 
 namespace ft {
 
 class RiskManager : public RiskManagementInterface {
  public:
-  explicit RiskManager(const PositionManager* pos_mgr);
+  RiskManager(const Config& config, const PositionManager* pos_mgr,
+              const AccountLedger* ledger,
+              const StrategyIdTable* strategy_ids);
 
+  /*
+   * 在内置规则之后动态添加规则，内置规则见Pipeline
+   */
   void add_rule(std::shared_ptr<RiskRuleInterface> rule);
 
   int check_order_req(const OrderReq* req) override;
@@ -29,9 +42,16 @@ class RiskManager : public RiskManagementInterface {
 
   void on_order_completed(uint64_t engine_order_id, int error_code) override;
 
+  void on_tick(const TickData* tick) override;
+
  private:
+  // 内置规则按顺序检查，动态添加的规则最后检查
+  using Pipeline =
+      RiskPipeline<PriceLimitRule, AvailablePosCheck, AvailableFundCheck,
+                   NoSelfTradeRule, ThrottleRateLimit, DynamicRuleSet>;
+
   const PositionManager* pos_mgr_;
-  std::list<std::shared_ptr<RiskRuleInterface>> rules_;
+  Pipeline pipeline_;
 };
 
 }  // namespace ft
@@ -0,0 +1,134 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_RISKMANAGEMENT_RISKPIPELINE_H_
+#define FT_SRC_RISKMANAGEMENT_RISKPIPELINE_H_
+
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "Core/ErrorCode.h"
+#include "RiskManagement/RiskRuleInterface.h"
+
+namespace ft {
+
+/*
+ * 编译期组合的风控规则链
+ *
+ * 规则的具体类型在编译期确定，按模板参数的顺序依次检查，遇到第一个
+ * 未通过的规则即返回其错误码。所有回调都以限定名直接调用具体类型的
+ * 函数，不经过虚函数表；规则没有覆盖的回调调用的是RiskRuleInterface中
+ * 的空实现，内联后不产生任何代码
+ *
+ * 规则仍然继承RiskRuleInterface，同一个规则也可以放入DynamicRuleSet
+ * 中动态使用
+ */
+template <class... Rules>
+class RiskPipeline {
+ public:
+  explicit RiskPipeline(Rules&&... rules) : rules_(std::move(rules)...) {}
+
+  template <class T>
+  T& get() {
+    return std::get<T>(rules_);
+  }
+
+  int check_order_req(const OrderReq* req) {
+    int error_code = NO_ERROR;
+    std::apply(
+        [&](auto&... rule) {
+          (((error_code = check(rule, req)) == NO_ERROR) && ...);
+        },
+        rules_);
+    return error_code;
+  }
+
+  void on_order_sent(uint64_t engine_order_id) {
+    std::apply([&](auto&... rule) { (sent(rule, engine_order_id), ...); },
+               rules_);
+  }
+
+  void on_order_traded(uint64_t engine_order_id, int this_traded,
+                       double traded_price) {
+    std::apply(
+        [&](auto&... rule) {
+          (traded(rule, engine_order_id, this_traded, traded_price), ...);
+        },
+        rules_);
+  }
+
+  void on_order_completed(uint64_t engine_order_id, int error_code) {
+    std::apply(
+        [&](auto&... rule) {
+          (completed(rule, engine_order_id, error_code), ...);
+        },
+        rules_);
+  }
+
+ private:
+  template <class T>
+  static int check(T& rule, const OrderReq* req) {
+    return rule.T::check_order_req(req);
+  }
+
+  template <class T>
+  static void sent(T& rule, uint64_t engine_order_id) {
+    rule.T::on_order_sent(engine_order_id);
+  }
+
+  template <class T>
+  static void traded(T& rule, uint64_t engine_order_id, int this_traded,
+                     double traded_price) {
+    rule.T::on_order_traded(engine_order_id, this_traded, traded_price);
+  }
+
+  template <class T>
+  static void completed(T& rule, uint64_t engine_order_id, int error_code) {
+    rule.T::on_order_completed(engine_order_id, error_code);
+  }
+
+ private:
+  std::tuple<Rules...> rules_;
+};
+
+/*
+ * 运行时添加的规则(如以插件形式加载的规则)，通过虚函数调用。作为
+ * RiskPipeline的最后一个规则使用，没有动态规则时只多一次空循环
+ */
+class DynamicRuleSet : public RiskRuleInterface {
+ public:
+  void add_rule(std::shared_ptr<RiskRuleInterface> rule) {
+    rules_.emplace_back(std::move(rule));
+  }
+
+  int check_order_req(const OrderReq* req) override {
+    for (auto& rule : rules_) {
+      int error_code = rule->check_order_req(req);
+      if (error_code != NO_ERROR) return error_code;
+    }
+    return NO_ERROR;
+  }
+
+  void on_order_sent(uint64_t engine_order_id) override {
+    for (auto& rule : rules_) rule->on_order_sent(engine_order_id);
+  }
+
+  void on_order_traded(uint64_t engine_order_id, int this_traded,
+                       double traded_price) override {
+    for (auto& rule : rules_)
+      rule->on_order_traded(engine_order_id, this_traded, traded_price);
+  }
+
+  void on_order_completed(uint64_t engine_order_id, int error_code) override {
+    for (auto& rule : rules_)
+      rule->on_order_completed(engine_order_id, error_code);
+  }
+
+ private:
+  std::vector<std::shared_ptr<RiskRuleInterface>> rules_;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_RISKMANAGEMENT_RISKPIPELINE_H_
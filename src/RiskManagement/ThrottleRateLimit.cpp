@@ -2,79 +2,152 @@
 
 #include "RiskManagement/ThrottleRateLimit.h"
 
-#include "Core/ErrorCode.h"
+#include <spdlog/spdlog.h>
 
-namespace ft {
+#include <algorithm>
 
-ThrottleRateLimit::ThrottleRateLimit(uint64_t period_ms, uint64_t order_limit,
-                                     uint64_t volume_limit)
-    : order_limit_(order_limit),
-      volume_limit_(volume_limit),
-      period_ms_(period_ms) {}
+#include "Core/ContractTable.h"
+#include "Core/ErrorCode.h"
 
-int ThrottleRateLimit::check_order_req(const OrderReq* order) {
-  if ((order_limit_ == 0 && volume_limit_ == 0) || period_ms_ == 0)
-    return NO_ERROR;
+namespace ft {
 
-  uint64_t current_ms = get_current_ms();
-  uint64_t lower_bound_ms = current_ms - period_ms_;
+ThrottleRateLimit::ThrottleRateLimit(const Config& config,
+                                     const StrategyIdTable* strategy_ids)
+    : strategy_ids_(strategy_ids),
+      account_limit_(config.account_throttle),
+      strategy_default_(config.strategy_throttle),
+      strategy_overrides_(config.strategy_throttles) {
+  if (config.throttle_period_ms == 0) return;
+  bucket_ms_ = std::max<uint64_t>(
+      config.throttle_period_ms / ThrottleWindow::kBuckets, 1);
+
+  bool has_strategy_limit = is_limited(strategy_default_);
+  for (const auto& [strategy_id, limit] : strategy_overrides_)
+    has_strategy_limit |= is_limited(limit);
+  if (has_strategy_limit) {
+    strategy_windows_.resize(StrategyIdTable::kMaxStrategies);
+    strategy_limits_.resize(StrategyIdTable::kMaxStrategies);
+    strategy_resolved_.resize(StrategyIdTable::kMaxStrategies, false);
+  }
 
-  if (order_limit_ > 0) {
-    for (auto iter = order_tm_record_.begin();
-         iter != order_tm_record_.end();) {
-      if (std::get<0>(*iter) > lower_bound_ms) break;
-      iter = order_tm_record_.erase(iter);
+  bool has_ticker_limit = is_limited(config.ticker_throttle);
+  for (const auto& [ticker, limit] : config.ticker_throttles)
+    has_ticker_limit |= is_limited(limit);
+  if (has_ticker_limit) {
+    ticker_windows_.resize(ContractTable::size() + 1);
+    ticker_limits_.resize(ContractTable::size() + 1, config.ticker_throttle);
+    for (const auto& [ticker, limit] : config.ticker_throttles) {
+      auto contract = ContractTable::get_by_ticker(ticker);
+      if (!contract) {
+        spdlog::warn("[ThrottleRateLimit] Unknown ticker {}", ticker);
+        continue;
+      }
+      ticker_limits_[contract->index] = limit;
     }
+  }
+}
 
-    if (order_tm_record_.size() >= order_limit_) {
-      spdlog::error(
-          "[ThrottleRateLimit::check] Order num reached limit within {} ms. "
-          "Current: {}, Limit: {}",
-          period_ms_, order_tm_record_.size(), order_limit_);
-      return ERR_THROTTLE_RATE_LIMIT;
-    }
+const ThrottleLimit& ThrottleRateLimit::strategy_limit(
+    uint32_t strategy_index) {
+  if (!strategy_resolved_[strategy_index]) {
+    auto iter = strategy_overrides_.find(strategy_ids_->name(strategy_index));
+    strategy_limits_[strategy_index] =
+        iter != strategy_overrides_.end() ? iter->second : strategy_default_;
+    strategy_resolved_[strategy_index] = true;
+  }
+  return strategy_limits_[strategy_index];
+}
 
-    order_tm_record_.emplace_back(
-        std::make_tuple(current_ms, order->engine_order_id));
+int ThrottleRateLimit::check_order_req(const OrderReq* order) {
+  if (bucket_ms_ == 0) return NO_ERROR;
+
+  uint64_t epoch = get_current_ms() / bucket_ms_;
+  uint64_t volume = order->volume;
+
+  account_window_.advance(epoch);
+  if (account_window_.exceeds(account_limit_, volume)) {
+    spdlog::error(
+        "[ThrottleRateLimit::check] Account reached limit. Orders: {}/{}, "
+        "Volume: {}+{}/{}",
+        account_window_.orders(), account_limit_.order_limit,
+        account_window_.volume(), volume, account_limit_.volume_limit);
+    return ERR_THROTTLE_RATE_LIMIT;
   }
 
-  if (volume_limit_ > 0) {
-    for (auto iter = volume_tm_record_.begin();
-         iter != volume_tm_record_.end();) {
-      if (std::get<0>(*iter) > lower_bound_ms) break;
-      volume_count_ -= std::get<1>(*iter);
-      iter = volume_tm_record_.erase(iter);
+  ThrottleWindow* strategy_window = nullptr;
+  uint32_t strategy_index = order->strategy_index;
+  if (!strategy_windows_.empty() && strategy_index != StrategyIdTable::kNone &&
+      strategy_index < StrategyIdTable::kMaxStrategies) {
+    const auto& limit = strategy_limit(strategy_index);
+    if (is_limited(limit)) {
+      strategy_window = &strategy_windows_[strategy_index];
+      strategy_window->advance(epoch);
+      if (strategy_window->exceeds(limit, volume)) {
+        spdlog::error(
+            "[ThrottleRateLimit::check] Strategy {} reached limit. "
+            "Orders: {}/{}, Volume: {}+{}/{}",
+            strategy_ids_->name(strategy_index), strategy_window->orders(),
+            limit.order_limit, strategy_window->volume(), volume,
+            limit.volume_limit);
+        return ERR_THROTTLE_RATE_LIMIT;
+      }
     }
+  }
 
-    if (volume_count_ + order->volume > volume_limit_) {
-      spdlog::error(
-          "[ThrottleRateLimit::check] Volume reach limit within {} ms. "
-          "This Order: {}, Current: {}, Limit: {}",
-          period_ms_, order->volume, volume_count_, volume_limit_);
-      return ERR_THROTTLE_RATE_LIMIT;
+  ThrottleWindow* ticker_window = nullptr;
+  uint32_t ticker_index = order->ticker_index;
+  if (ticker_index < ticker_windows_.size()) {
+    const auto& limit = ticker_limits_[ticker_index];
+    if (is_limited(limit)) {
+      ticker_window = &ticker_windows_[ticker_index];
+      ticker_window->advance(epoch);
+      if (ticker_window->exceeds(limit, volume)) {
+        auto contract = ContractTable::get_by_index(ticker_index);
+        spdlog::error(
+            "[ThrottleRateLimit::check] Ticker {} reached limit. "
+            "Orders: {}/{}, Volume: {}+{}/{}",
+            contract ? contract->ticker : "", ticker_window->orders(),
+            limit.order_limit, ticker_window->volume(), volume,
+            limit.volume_limit);
+        return ERR_THROTTLE_RATE_LIMIT;
+      }
     }
-
-    volume_count_ += order->volume;
-    volume_tm_record_.emplace_back(
-        std::make_tuple(current_ms, order->volume, order->engine_order_id));
   }
 
+  // 全部通过后才计数，被拒绝的订单不占用额度
+  account_window_.add(volume);
+  if (strategy_window) strategy_window->add(volume);
+  if (ticker_window) ticker_window->add(volume);
+
+  auto& record = records_[record_count_++ % kMaxBatchOrders];
+  record.engine_order_id = order->engine_order_id;
+  record.epoch = epoch;
+  record.volume = volume;
+  record.strategy_index = strategy_window ? strategy_index : 0;
+  record.ticker_index = ticker_window ? ticker_index : 0;
+
   return NO_ERROR;
 }
 
 void ThrottleRateLimit::on_order_completed(uint64_t engine_order_id,
                                            int error_code) {
-  if (error_code <= ERR_SEND_FAILED) {
-    if (!volume_tm_record_.empty() &&
-        std::get<2>(volume_tm_record_.back()) == engine_order_id) {
-      volume_count_ -= std::get<1>(volume_tm_record_.back());
-      volume_tm_record_.pop_back();
-    }
-
-    if (!order_tm_record_.empty() &&
-        std::get<1>(order_tm_record_.back()) == engine_order_id) {
-      order_tm_record_.pop_back();
-    }
+  // 只有没有发出去的订单才撤销计数，正常结束的订单仍计入窗口
+  if (error_code == NO_ERROR || error_code > ERR_SEND_FAILED) return;
+  if (bucket_ms_ == 0) return;
+
+  uint64_t n = std::min<uint64_t>(record_count_, kMaxBatchOrders);
+  for (uint64_t i = 1; i <= n; ++i) {
+    auto& record = records_[(record_count_ - i) % kMaxBatchOrders];
+    if (record.engine_order_id != engine_order_id) continue;
+
+    account_window_.remove(record.epoch, record.volume);
+    if (record.strategy_index != 0)
+      strategy_windows_[record.strategy_index].remove(record.epoch,
+                                                      record.volume);
+    if (record.ticker_index != 0)
+      ticker_windows_[record.ticker_index].remove(record.epoch, record.volume);
+    record.engine_order_id = 0;
+    return;
   }
 }
 
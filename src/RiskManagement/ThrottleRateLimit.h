@@ -3,13 +3,15 @@
 #ifndef FT_SRC_RISKMANAGEMENT_THROTTLERATELIMIT_H_
 #define FT_SRC_RISKMANAGEMENT_THROTTLERATELIMIT_H_
 
-#include <spdlog/spdlog.h>
+#include <time.h>
 
-#include <list>
+#include <cstdint>
+#include <map>
 #include <string>
-#include <tuple>
-#include <utility>
+#include <vector>
 
+#include "Common/StrategyIdTable.h"
+#include "Core/Config.h"
 #include "RiskManagement/RiskRuleInterface.h"
 
 namespace ft {
@@ -20,27 +22,133 @@ inline uint64_t get_current_ms() {
   return ts.tv_nsec / 1000000 + ts.tv_sec * 1000;
 }
 
-class ThrottleRateLimit : public RiskRuleInterface {
+/*
+ * 分桶的滑动窗口计数器
+ *
+ * 把period_ms等分为kBuckets个桶，每个桶记录该时间片内的报单笔数和数量，
+ * 窗口内的总数随桶的过期增量更新。窗口的实际长度在period_ms的15/16到1之间，
+ * 记录一笔报单只需要常数次整数运算，不分配内存
+ */
+class ThrottleWindow {
  public:
-  ThrottleRateLimit(uint64_t period_ms, uint64_t order_limit,
-                    uint64_t volume_limit);
+  static constexpr uint64_t kBuckets = 16;
+
+  /*
+   * 推进到epoch(当前时间/桶长度)，清空已滑出窗口的桶
+   */
+  void advance(uint64_t epoch) {
+    if (epoch <= epoch_) return;
+
+    uint64_t first = epoch - epoch_ > kBuckets ? epoch - kBuckets + 1
+                                               : epoch_ + 1;
+    for (uint64_t e = first; e <= epoch; ++e) {
+      auto& bucket = buckets_[e % kBuckets];
+      orders_ -= bucket.orders;
+      volume_ -= bucket.volume;
+      bucket.orders = 0;
+      bucket.volume = 0;
+    }
+    epoch_ = epoch;
+  }
+
+  /*
+   * 再报一笔volume手的订单是否超限，需先advance到当前时间
+   */
+  bool exceeds(const ThrottleLimit& limit, uint64_t volume) const {
+    return (limit.order_limit > 0 && orders_ >= limit.order_limit) ||
+           (limit.volume_limit > 0 && volume_ + volume > limit.volume_limit);
+  }
+
+  void add(uint64_t volume) {
+    auto& bucket = buckets_[epoch_ % kBuckets];
+    ++bucket.orders;
+    bucket.volume += volume;
+    ++orders_;
+    volume_ += volume;
+  }
+
+  /*
+   * 撤销在epoch时记录的一笔报单，该桶已滑出窗口时不需要处理
+   */
+  void remove(uint64_t epoch, uint64_t volume) {
+    if (epoch + kBuckets <= epoch_) return;
+
+    auto& bucket = buckets_[epoch % kBuckets];
+    if (bucket.orders == 0) return;
+    --bucket.orders;
+    bucket.volume -= volume;
+    --orders_;
+    volume_ -= volume;
+  }
+
+  uint64_t orders() const { return orders_; }
+
+  uint64_t volume() const { return volume_; }
+
+ private:
+  struct Bucket {
+    uint64_t orders = 0;
+    uint64_t volume = 0;
+  };
+
+  Bucket buckets_[kBuckets]{};
+  uint64_t epoch_ = 0;
+  uint64_t orders_ = 0;
+  uint64_t volume_ = 0;
+};
+
+/*
+ * 报单流控，分别对整个账户、每个策略以及每个合约在period_ms内的报单笔数
+ * 和报单数量计数，任何一个超限即拒单
+ *
+ * 策略的限制在该策略第一次报单时按策略ID查找，合约的限制在构造时按合约
+ * 代码查找，都没有单独设置时使用默认设置。没有配置任何策略或合约限制时
+ * 不分配对应的计数器
+ */
+class ThrottleRateLimit final : public RiskRuleInterface {
+ public:
+  ThrottleRateLimit(const Config& config, const StrategyIdTable* strategy_ids);
 
   int check_order_req(const OrderReq* order) override;
 
   void on_order_completed(uint64_t engine_order_id, int error_code) override;
 
  private:
-  uint64_t order_limit_ = 0;
-  uint64_t volume_limit_ = 0;
-  uint64_t period_ms_ = 0;
+  static bool is_limited(const ThrottleLimit& limit) {
+    return limit.order_limit > 0 || limit.volume_limit > 0;
+  }
+
+  const ThrottleLimit& strategy_limit(uint32_t strategy_index);
+
+ private:
+  // 已计数的报单，发送失败或被后面的规则拒绝时据此撤销计数。一批订单
+  // 检查完后立即发送，保留最近kMaxBatchOrders笔即可
+  struct Record {
+    uint64_t engine_order_id;
+    uint64_t epoch;
+    uint64_t volume;
+    uint32_t strategy_index;
+    uint32_t ticker_index;
+  };
+
+  const StrategyIdTable* strategy_ids_;
+  uint64_t bucket_ms_ = 0;  // 为0表示不限制
+
+  ThrottleLimit account_limit_{};
+  ThrottleWindow account_window_{};
+
+  ThrottleLimit strategy_default_{};
+  std::map<std::string, ThrottleLimit> strategy_overrides_;
 
-  uint64_t volume_count_ = 0;
+  std::vector<ThrottleWindow> strategy_windows_;
+  std::vector<ThrottleLimit> strategy_limits_;
+  std::vector<bool> strategy_resolved_;
 
-  // (time_ms, engine_order_id)
-  std::list<std::tuple<uint64_t, uint64_t>> order_tm_record_;
+  std::vector<ThrottleWindow> ticker_windows_;
+  std::vector<ThrottleLimit> ticker_limits_;
 
-  // (time_ms, volume, engine_order_id)
-  std::list<std::tuple<uint64_t, int, uint64_t>> volume_tm_record_;
+  Record records_[kMaxBatchOrders]{};
+  uint64_t record_count_ = 0;
 };
 
 }  // namespace ft
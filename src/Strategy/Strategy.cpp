@@ -2,38 +2,193 @@
 
 #include "Strategy/Strategy.h"
 
+#include <poll.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "Core/ErrorCode.h"
+#include "Utils/Misc.h"
+
 namespace ft {
 
+namespace {
+
+// hybrid模式下连续多少次没有事件后转为休眠
+constexpr uint64_t kHybridSpins = 100000;
+
+// 没有定时器时的最长休眠时间；如果有数据源不支持poll(如shm)，
+// 休眠时间不超过kMaxSleepWithoutFdMs以便及时检查这些数据源
+constexpr uint64_t kMaxSleepMs = 100;
+constexpr uint64_t kMaxSleepWithoutFdMs = 1;
+
+uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+/*
+ * 行情、订单回报和定时器在同一个线程中轮流处理，策略的回调不会并发执行，
+ * 不需要加锁
+ */
 void Strategy::run() {
+  if (event_loop_mode_.empty())
+    event_loop_mode_ =
+        ipc_transport_ == IPC_SHM ? EVENT_LOOP_BUSY : EVENT_LOOP_BLOCKING;
+
+  if (event_loop_mode_ != EVENT_LOOP_BUSY &&
+      event_loop_mode_ != EVENT_LOOP_BLOCKING &&
+      event_loop_mode_ != EVENT_LOOP_HYBRID) {
+    spdlog::error("[Strategy::run] Unknown event loop mode: {}",
+                  event_loop_mode_);
+    return;
+  }
+
+  quote_sub_ = create_quote_subscriber(ipc_transport_, &proto_);
+  if (!quote_sub_) {
+    spdlog::error("[Strategy::run] Failed to create quote subscriber");
+    return;
+  }
+
+  quote_table_ = attach_shm_object<QuoteTable>(&quote_table_shm_,
+                                               proto_.quote_table_shm_name());
+  if (!quote_table_)
+    spdlog::warn("[Strategy::run] Failed to open {}",
+                 proto_.quote_table_shm_name());
+
   on_init();
 
-  std::thread rsp_receiver([this] {
-    rsp_redis_.subscribe({strategy_id_});
+  rsp_sub_ =
+      create_order_rsp_subscriber(ipc_transport_, &proto_, strategy_id_);
+  if (!rsp_sub_) {
+    spdlog::error("[Strategy::run] Failed to create rsp subscriber");
+    return;
+  }
+
+  if (latency_.enabled()) install_latency_dump_handler();
 
-    for (;;) {
-      auto reply = rsp_redis_.get_sub_reply();
-      if (reply) {
-        auto rsp =
-            reinterpret_cast<const OrderResponse*>(reply->element[2]->str);
-        on_order_rsp(rsp);
-      }
-    }
-  });
+  // 同步上一次运行时遗留的未完成订单
+  sender_.query_orders();
 
+  uint64_t lost = 0;
+  uint64_t idle_count = 0;
   for (;;) {
-    auto reply = tick_redis_.get_sub_reply();
-    if (reply) {
-      auto tick = reinterpret_cast<const TickData*>(reply->element[2]->str);
+    bool has_event = false;
+    if (latency_.enabled()) latency_.dump_if_requested("Strategy");
+
+    if (auto tick = quote_sub_->try_get_tick()) {
       on_tick(tick);
+      has_event = true;
+    }
+
+    if (auto rsp = rsp_sub_->try_get_rsp()) {
+      if (rsp_sub_->lost() != lost) {
+        spdlog::warn("[Strategy::run] {} order responses lost, resync orders",
+                     rsp_sub_->lost() - lost);
+        lost = rsp_sub_->lost();
+        sender_.query_orders();
+      }
+      if (latency_.enabled()) trace_rsp(rsp);
+      on_order_rsp(rsp);
+      has_event = true;
+    }
+
+    if (process_timers()) has_event = true;
+
+    if (has_event) {
+      idle_count = 0;
+      continue;
+    }
+
+    if (event_loop_mode_ == EVENT_LOOP_BUSY) {
+      cpu_relax();
+      continue;
     }
+
+    if (event_loop_mode_ == EVENT_LOOP_HYBRID && ++idle_count < kHybridSpins) {
+      cpu_relax();
+      continue;
+    }
+
+    wait_for_events();
   }
 }
 
-void Strategy::subscribe(const std::vector<std::string>& sub_list) {
-  std::vector<std::string> topics;
-  for (const auto& ticker : sub_list)
-    topics.emplace_back(proto_.quote_key(ticker));
-  tick_redis_.subscribe(topics);
+void Strategy::subscribe(const std::vector<std::string>& sub_list,
+                         bool conflate) {
+  quote_sub_->subscribe(sub_list);
+  if (conflate) quote_sub_->conflate(sub_list);
+}
+
+uint32_t Strategy::add_timer(uint64_t interval_ms) {
+  Timer timer;
+  timer.id = timers_.size() + 1;
+  timer.interval_ns = std::max<uint64_t>(interval_ms, 1) * 1000000;
+  timer.next_ns = now_ns() + timer.interval_ns;
+  timers_.emplace_back(timer);
+  return timer.id;
+}
+
+/*
+ * 有成交的回报计入报单到成交的往返延迟，其余未完成且没有错误的回报即
+ * 委托回报。重新同步订单时推送的回报没有指令时间，不计入往返延迟
+ */
+void Strategy::trace_rsp(const OrderResponse* rsp) {
+  uint64_t now = latency_.now();
+  latency_.record(LAT_RSP_TRANSPORT, rsp->rsp_time_ns, now);
+  if (rsp->this_traded > 0)
+    latency_.record(LAT_FILL_ROUND_TRIP, rsp->cmd_time_ns, now);
+  else if (!rsp->completed && rsp->error_code == NO_ERROR)
+    latency_.record(LAT_ACK_ROUND_TRIP, rsp->cmd_time_ns, now);
+}
+
+bool Strategy::process_timers() {
+  if (timers_.empty()) return false;
+
+  bool fired = false;
+  uint64_t now = now_ns();
+  for (auto& timer : timers_) {
+    if (now < timer.next_ns) continue;
+
+    // 处理太慢错过的周期不再补发
+    timer.next_ns += timer.interval_ns;
+    if (timer.next_ns <= now) timer.next_ns = now + timer.interval_ns;
+
+    on_timer(timer.id);
+    fired = true;
+  }
+
+  return fired;
+}
+
+void Strategy::wait_for_events() {
+  pollfd fds[2];
+  nfds_t nfds = 0;
+  uint64_t timeout_ms = kMaxSleepMs;
+
+  for (int fd : {quote_sub_->fd(), rsp_sub_->fd()}) {
+    if (fd < 0) {
+      timeout_ms = kMaxSleepWithoutFdMs;
+      continue;
+    }
+    fds[nfds].fd = fd;
+    fds[nfds].events = POLLIN;
+    fds[nfds].revents = 0;
+    ++nfds;
+  }
+
+  if (!timers_.empty()) {
+    uint64_t now = now_ns();
+    uint64_t next = timers_.front().next_ns;
+    for (const auto& timer : timers_) next = std::min(next, timer.next_ns);
+    uint64_t wait_ms = next > now ? (next - now + 999999) / 1000000 : 0;
+    timeout_ms = std::min(timeout_ms, wait_ms);
+  }
+
+  poll(fds, nfds, static_cast<int>(timeout_ms));
 }
 
 }  // namespace ft
@@ -7,14 +7,19 @@
 #include <string>
 #include <vector>
 
+#include "Common/LatencyStats.h"
+#include "Common/OrderRspTransport.h"
 #include "Common/OrderSender.h"
 #include "Common/PositionHelper.h"
+#include "Common/QuoteTable.h"
+#include "Common/QuoteTransport.h"
 #include "Core/Constants.h"
 #include "Core/Contract.h"
 #include "Core/ContractTable.h"
 #include "Core/Position.h"
 #include "Core/Protocol.h"
 #include "Core/TickData.h"
+#include "IPC/SharedMemory.h"
 #include "IPC/redis.h"
 
 namespace ft {
@@ -29,8 +34,14 @@ class Strategy {
 
   virtual void on_tick(const TickData* tick) {}
 
+  /*
+   * 启动及回报丢失后会重新同步订单，同步的结果也通过这里推送，见
+   * OrderResponse::snapshot
+   */
   virtual void on_order_rsp(const OrderResponse* order) {}
 
+  virtual void on_timer(uint32_t timer_id) {}
+
   virtual void on_exit() {}
 
   /* 仅供加载器调用，内部不可使用 */
@@ -42,6 +53,30 @@ class Strategy {
     sender_.set_id(name);
   }
 
+  /* 需与交易引擎配置的ipc_transport一致，须在run之前调用 */
+  void set_ipc_transport(const std::string& transport) {
+    ipc_transport_ = transport;
+    sender_.set_ipc_transport(transport);
+    pos_helper_.set_ipc_transport(transport);
+  }
+
+  /*
+   * 事件循环的等待方式，见Constants.h。不设置时shm下为busy，
+   * redis下为blocking
+   */
+  void set_event_loop_mode(const std::string& mode) {
+    event_loop_mode_ = mode;
+  }
+
+  /*
+   * 统计指令和回报的传输延迟及报单到收到回报的往返延迟，收到SIGUSR1时
+   * 输出。须在run之前调用
+   */
+  void set_latency_trace(bool enabled) {
+    latency_.set_enabled(enabled);
+    sender_.set_latency_trace(enabled);
+  }
+
   void set_account_id(uint64_t account_id) {
     proto_.set_account(account_id);
     sender_.set_account(account_id);
@@ -49,7 +84,18 @@ class Strategy {
   }
 
  protected:
-  void subscribe(const std::vector<std::string>& sub_list);
+  /*
+   * conflate为true时这些合约使用合并模式：处理不过来时只保留每个合约
+   * 最新的一笔tick，on_tick收到的总是最新行情而不是积压的旧行情
+   */
+  void subscribe(const std::vector<std::string>& sub_list,
+                 bool conflate = false);
+
+  /*
+   * 添加一个定时器，每隔interval_ms毫秒在事件循环中回调一次on_timer，
+   * 返回定时器的id
+   */
+  uint32_t add_timer(uint64_t interval_ms);
 
   void buy_open(const std::string& ticker, int volume, double price,
                 uint64_t type = OrderType::FAK, uint32_t user_order_id = 0) {
@@ -75,14 +121,25 @@ class Strategy {
                        type, price, user_order_id);
   }
 
+  void send_order_batch(const TraderOrderReq* reqs, uint32_t count) {
+    sender_.send_order_batch(reqs, count);
+  }
+
   void cancel_order(uint64_t order_id) { sender_.cancel_order(order_id); }
 
+  void replace_order(uint64_t order_id, double price, int volume = 0,
+                     uint32_t user_order_id = 0) {
+    sender_.replace_order(order_id, price, volume, user_order_id);
+  }
+
   void cancel_for_ticker(const std::string& ticker) {
     sender_.cancel_for_ticker(ticker);
   }
 
   void cancel_all() { sender_.cancel_all(); }
 
+  void cancel_strategy() { sender_.cancel_strategy(); }
+
   Position get_position(const std::string& ticker) const {
     return pos_helper_.get_position(ticker);
   }
@@ -91,7 +148,41 @@ class Strategy {
 
   double get_float_pnl() const { return pos_helper_.get_float_pnl(); }
 
+  /*
+   * 账户资金，只有ipc_transport为shm时可用
+   */
+  Account get_account() const { return pos_helper_.get_account(); }
+
+  /*
+   * 读取任意合约的最新行情，不需要订阅该合约。
+   * 合约不存在或还没有收到过该合约的行情时返回false
+   */
+  bool get_latest_quote(const std::string& ticker,
+                        QuoteSnapshot* quote) const {
+    auto contract = ContractTable::get_by_ticker(ticker);
+    if (!contract) return false;
+    return get_latest_quote(contract->index, quote);
+  }
+
+  bool get_latest_quote(uint32_t ticker_index, QuoteSnapshot* quote) const {
+    if (!quote_table_ || !quote_table_->load(ticker_index, quote))
+      return false;
+    return quote->update_seq > 0;
+  }
+
  private:
+  struct Timer {
+    uint32_t id;
+    uint64_t interval_ns;
+    uint64_t next_ns;
+  };
+
+  bool process_timers();
+
+  void trace_rsp(const OrderResponse* rsp);
+
+  void wait_for_events();
+
   void send_order(const std::string& ticker, int volume, uint32_t direction,
                   uint32_t offset, uint32_t type, double price,
                   uint32_t user_order_id) {
@@ -102,10 +193,16 @@ class Strategy {
  private:
   StrategyIdType strategy_id_;
   OrderSender sender_;
-  RedisSession tick_redis_;
-  RedisSession rsp_redis_;
+  std::string ipc_transport_{IPC_REDIS};
+  std::string event_loop_mode_{};
+  std::vector<Timer> timers_{};
+  std::unique_ptr<QuoteSubscriber> quote_sub_{nullptr};
+  std::unique_ptr<OrderRspSubscriber> rsp_sub_{nullptr};
   ProtocolQueryCenter proto_;
   PositionHelper pos_helper_;
+  SharedMemory quote_table_shm_;
+  const QuoteTable* quote_table_{nullptr};
+  LatencyTracer latency_;
 };
 
 #define EXPORT_STRATEGY(type) \
@@ -12,14 +12,20 @@
 static void usage() {
   printf("usage: ./strategy-loader [--account=<account>] [--config=<file>]\n");
   printf("                         [--contracts=<file>] [-h -? --help]\n");
-  printf("                         [--id=<id>] [--loglevel=level]\n");
+  printf("                         [--id=<id>] [--ipc=<redis|shm>]\n");
+  printf("                         [--latency]\n");
+  printf("                         [--loglevel=level]\n");
+  printf("                         [--loop=<busy|blocking|hybrid>]\n");
   printf("                         [--strategy=<so>]\n");
   printf("\n");
   printf("    --account           账户\n");
   printf("    --contracts         合约列表文件\n");
   printf("    -h, -?, --help      帮助\n");
   printf("    --id                策略的唯一标识，用于接收订单回报\n");
+  printf("    --ipc               与交易引擎的通讯方式，需与引擎配置一致\n");
+  printf("    --latency           统计订单延迟，收到SIGUSR1时输出\n");
   printf("    --loglevel          日志等级(info, warn, error, debug, trace)\n");
+  printf("    --loop              事件循环的等待方式(busy,blocking,hybrid)\n");
   printf("    --strategy          要加载的策略的动态库\n");
 }
 
@@ -29,7 +35,10 @@ int main() {
   std::string strategy_file = getarg("", "--strategy");
   std::string log_level = getarg("info", "--loglevel");
   std::string strategy_id = getarg("Strategy", "id");
+  std::string ipc_transport = getarg("redis", "--ipc");
+  std::string event_loop_mode = getarg("", "--loop");
   uint64_t account_id = getarg(0ULL, "--account");
+  bool latency_trace = getarg(false, "--latency");
   bool help = getarg(false, "-h", "--help", "-?");
 
   if (help) {
@@ -65,6 +74,9 @@ int main() {
 
   auto strategy = create_strategy();
   strategy->set_id(strategy_id);
+  strategy->set_ipc_transport(ipc_transport);
+  strategy->set_event_loop_mode(event_loop_mode);
   strategy->set_account_id(account_id);
+  strategy->set_latency_trace(latency_trace);
   strategy->run();
 }
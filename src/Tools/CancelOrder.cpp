@@ -7,6 +7,7 @@
 int main() {
   std::string ticker = getarg("", "--ticker");
   uint64_t account = getarg(0ULL, "--account");
+  std::string ipc_transport = getarg("redis", "--ipc");
   uint64_t order_id = getarg(0ULL, "--order_id");
 
   if (account == 0) {
@@ -15,6 +16,7 @@ int main() {
   }
 
   ft::OrderSender sender;
+  sender.set_ipc_transport(ipc_transport);
   sender.set_account(account);
 
   if (order_id != 0)
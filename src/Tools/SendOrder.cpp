@@ -12,6 +12,7 @@ int main() {
   std::string offset = getarg("open", "--offset");
   std::string order_type = getarg("fak", "--order_type");
   uint64_t account = getarg(0ULL, "--account");
+  std::string ipc_transport = getarg("redis", "--ipc");
   int volume = getarg(0, "--volume");
   double price = getarg(0.0, "--price");
 
@@ -75,6 +76,7 @@ int main() {
   }
 
   ft::OrderSender sender;
+  sender.set_ipc_transport(ipc_transport);
   sender.set_account(account);
   sender.send_order(ticker, volume, d, o, k, price, 0);
 }
@@ -0,0 +1,168 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <getopt.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/Metrics.h"
+#include "Core/ErrorCode.h"
+#include "Core/Protocol.h"
+
+static void usage() {
+  printf("usage: ./ft-stat --account=<account> [--interval=<seconds>]\n");
+  printf("                 [--count=<n>] [--risk] [-h -? --help]\n");
+  printf("\n");
+  printf("    --account           账户\n");
+  printf("    --interval          采样间隔，单位为秒，默认为1\n");
+  printf("    --count             采样次数，默认为0即一直采样\n");
+  printf("    --risk              按风控规则输出拒单速率\n");
+  printf("    -h, -?, --help      帮助\n");
+}
+
+namespace {
+
+constexpr int kHeaderInterval = 20;  // 每输出多少行重新输出一次表头
+
+struct Column {
+  const char* name;
+  bool is_gauge;
+  uint32_t id;
+};
+
+// 速率为每秒的次数，瞬时值直接输出
+const Column kColumns[] = {
+    {"cmd/s", false, ft::MC_CMD_RECEIVED},
+    {"sent/s", false, ft::MC_ORDER_SENT},
+    {"fail/s", false, ft::MC_ORDER_SEND_FAILED},
+    {"acc/s", false, ft::MC_ORDER_ACCEPTED},
+    {"rej/s", false, ft::MC_ORDER_REJECTED},
+    {"trd/s", false, ft::MC_ORDER_TRADED},
+    {"cxl/s", false, ft::MC_ORDER_CANCELED},
+    {"cxlrej/s", false, ft::MC_CANCEL_REJECTED},
+    {"risk/s", false, ft::MC_RISK_REJECTED},
+    {"tick/s", false, ft::MC_GATEWAY_TICK},
+    {"gwrsp/s", false, ft::MC_GATEWAY_ORDER_RSP},
+    {"gwerr/s", false, ft::MC_GATEWAY_ERROR},
+    {"pubfail/s", false, ft::MC_PUBLISH_FAILED},
+    {"logdrop/s", false, ft::MC_LOG_DROPPED},
+    {"live", true, ft::MG_LIVE_ORDERS},
+    {"evq", true, ft::MG_EVENT_QUEUE_DEPTH},
+    {"pubq", true, ft::MG_PUBLISH_QUEUE_DEPTH},
+};
+
+/*
+ * 一次采样得到的所有计数，按输出的列排列
+ */
+std::vector<uint64_t> sample(const ft::MetricsPage* page, bool risk) {
+  std::vector<uint64_t> values;
+  if (risk) {
+    for (int code = 1; code < ft::ERR_SEND_FAILED; ++code)
+      values.emplace_back(page->risk_rejects(code));
+    return values;
+  }
+
+  for (const auto& col : kColumns) {
+    values.emplace_back(
+        col.is_gauge ? page->gauge(static_cast<ft::MetricGauge>(col.id))
+                     : page->counter(static_cast<ft::MetricCounter>(col.id)));
+  }
+  return values;
+}
+
+std::vector<std::string> column_names(bool risk) {
+  std::vector<std::string> names;
+  if (risk) {
+    // 去掉ERR_前缀
+    for (int code = 1; code < ft::ERR_SEND_FAILED; ++code)
+      names.emplace_back(ft::error_code_str(code) + 4);
+    return names;
+  }
+
+  for (const auto& col : kColumns) names.emplace_back(col.name);
+  return names;
+}
+
+}  // namespace
+
+int main() {
+  uint64_t account = getarg(0ULL, "--account");
+  uint64_t interval = getarg(1ULL, "--interval");
+  uint64_t count = getarg(0ULL, "--count");
+  bool risk = getarg(false, "--risk");
+  bool help = getarg(false, "-h", "--help", "-?");
+
+  if (help) {
+    usage();
+    exit(0);
+  }
+
+  if (account == 0) {
+    printf("Invalid account\n");
+    exit(-1);
+  }
+
+  if (interval == 0) interval = 1;
+
+  ft::ProtocolQueryCenter proto;
+  proto.set_account(account);
+
+  ft::SharedMemory shm;
+  if (!shm.open(proto.metrics_shm_name(), sizeof(ft::MetricsPage))) {
+    printf("Failed to open %s. Is the trading engine running?\n",
+           proto.metrics_shm_name().c_str());
+    exit(-1);
+  }
+
+  auto page = reinterpret_cast<const ft::MetricsPage*>(shm.data());
+  if (!page->is_ready()) {
+    printf("Metrics not ready\n");
+    exit(-1);
+  }
+
+  auto names = column_names(risk);
+  std::vector<int> widths;
+  for (const auto& name : names)
+    widths.emplace_back(std::max<int>(name.size(), 7) + 1);
+
+  std::vector<bool> is_gauge(names.size(), false);
+  if (!risk) {
+    for (std::size_t i = 0; i < names.size(); ++i)
+      is_gauge[i] = kColumns[i].is_gauge;
+  }
+
+  auto prev = sample(page, risk);
+  auto prev_time = std::chrono::steady_clock::now();
+  for (uint64_t n = 0; count == 0 || n < count; ++n) {
+    std::this_thread::sleep_for(std::chrono::seconds(interval));
+
+    auto cur = sample(page, risk);
+    auto cur_time = std::chrono::steady_clock::now();
+    double elapsed =
+        std::chrono::duration<double>(cur_time - prev_time).count();
+
+    if (n % kHeaderInterval == 0) {
+      for (std::size_t i = 0; i < names.size(); ++i)
+        printf("%*s", widths[i], names[i].c_str());
+      printf("\n");
+    }
+
+    for (std::size_t i = 0; i < cur.size(); ++i) {
+      if (is_gauge[i]) {
+        printf("%*lu", widths[i], cur[i]);
+        continue;
+      }
+      // 引擎重启后计数会清零，此时按0输出
+      uint64_t delta = cur[i] >= prev[i] ? cur[i] - prev[i] : 0;
+      printf("%*.0f", widths[i], delta / elapsed);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    prev = std::move(cur);
+    prev_time = cur_time;
+  }
+}
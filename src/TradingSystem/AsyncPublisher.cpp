@@ -0,0 +1,180 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/AsyncPublisher.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstring>
+#include <utility>
+
+#include "Common/Metrics.h"
+#include "Core/Constants.h"
+#include "Core/ContractTable.h"
+#include "Utils/Misc.h"
+
+namespace ft {
+
+namespace {
+
+class AsyncQuotePublisher : public QuotePublisher {
+ public:
+  explicit AsyncQuotePublisher(AsyncPublisher* async_pub)
+      : async_pub_(async_pub) {}
+
+  void publish(const Contract* contract, const TickData* tick) override {
+    async_pub_->publish_tick(contract, tick);
+  }
+
+ private:
+  AsyncPublisher* async_pub_;
+};
+
+class AsyncOrderRspPublisher : public OrderRspPublisher {
+ public:
+  explicit AsyncOrderRspPublisher(AsyncPublisher* async_pub)
+      : async_pub_(async_pub) {}
+
+  void publish(const std::string& strategy_id,
+               const OrderResponse* rsp) override {
+    async_pub_->publish_rsp(strategy_id, rsp);
+  }
+
+ private:
+  AsyncPublisher* async_pub_;
+};
+
+}  // namespace
+
+AsyncPublisher::AsyncPublisher(std::unique_ptr<QuotePublisher> quote_pub,
+                               std::unique_ptr<OrderRspPublisher> rsp_pub,
+                               const std::string& backpressure)
+    : quote_pub_(std::move(quote_pub)),
+      rsp_pub_(std::move(rsp_pub)),
+      backpressure_(backpressure) {
+  queue_ = std::make_unique<MpscQueue<Message, kQueueSize>>();
+  queue_->init();
+
+  if (backpressure_ == BACKPRESSURE_CONFLATE) {
+    tick_slot_count_ = ContractTable::size() + 1;  // ticker_index从1开始
+    tick_slots_ = std::make_unique<TickSlot[]>(tick_slot_count_);
+    for (std::size_t i = 0; i < tick_slot_count_; ++i)
+      tick_slots_[i].tick.init();
+  }
+
+  is_running_ = true;
+  io_thread_ = std::thread(&AsyncPublisher::process, this);
+}
+
+AsyncPublisher::~AsyncPublisher() {
+  is_running_ = false;
+  if (io_thread_.joinable()) io_thread_.join();
+}
+
+std::unique_ptr<QuotePublisher> AsyncPublisher::create_quote_publisher() {
+  return std::make_unique<AsyncQuotePublisher>(this);
+}
+
+std::unique_ptr<OrderRspPublisher> AsyncPublisher::create_rsp_publisher() {
+  return std::make_unique<AsyncOrderRspPublisher>(this);
+}
+
+void AsyncPublisher::publish_tick(const Contract* contract,
+                                  const TickData* tick) {
+  UNUSED(contract);
+
+  Message msg;
+  if (tick_slots_ && tick->ticker_index < tick_slot_count_) {
+    // 槽位中已有未发布的行情时直接覆盖，不需要再入队
+    auto& slot = tick_slots_[tick->ticker_index];
+    slot.tick.store(*tick);
+    if (slot.pending.exchange(true, std::memory_order_acq_rel)) return;
+
+    msg.type = MSG_CONFLATED_TICK;
+    msg.ticker_index = tick->ticker_index;
+    push(msg, false);
+    return;
+  }
+
+  msg.type = MSG_TICK;
+  msg.tick = *tick;
+  push(msg, backpressure_ == BACKPRESSURE_DROP);
+}
+
+void AsyncPublisher::publish_rsp(const std::string& strategy_id,
+                                 const OrderResponse* rsp) {
+  Message msg;
+  msg.type = MSG_ORDER_RSP;
+  strncpy(msg.order_rsp.strategy_id, strategy_id.c_str(),
+          sizeof(msg.order_rsp.strategy_id) - 1);
+  msg.order_rsp.strategy_id[sizeof(msg.order_rsp.strategy_id) - 1] = '\0';
+  msg.order_rsp.rsp = *rsp;
+  push(msg, false);
+}
+
+void AsyncPublisher::push(const Message& msg, bool can_drop) {
+  while (!queue_->try_push(msg)) {
+    if (can_drop) {
+      Metrics::add(MC_PUBLISH_FAILED);
+      auto dropped = dropped_.fetch_add(1, std::memory_order_relaxed) + 1;
+      if ((dropped & (dropped - 1)) == 0)
+        spdlog::warn("[AsyncPublisher::push] Queue full. {} ticks dropped",
+                     dropped);
+      return;
+    }
+    cpu_relax();
+  }
+}
+
+void AsyncPublisher::process() {
+  Message msg;
+  for (;;) {
+    // 一次最多取kMaxBatch条消息，一起发出
+    std::size_t count = 0;
+    while (count < kMaxBatch && queue_->try_pop(&msg)) {
+      handle(msg);
+      ++count;
+    }
+
+    Metrics::set(MG_PUBLISH_QUEUE_DEPTH, queue_->size());
+    if (count > 0) {
+      quote_pub_->flush();
+      rsp_pub_->flush();
+      continue;
+    }
+
+    // 退出前把队列中剩余的消息都发布出去
+    if (!is_running_) break;
+    queue_->wait(kWaitTimeoutMs);
+  }
+}
+
+void AsyncPublisher::handle(const Message& msg) {
+  switch (msg.type) {
+    case MSG_TICK: {
+      quote_pub_->publish(ContractTable::get_by_index(msg.tick.ticker_index),
+                          &msg.tick);
+      break;
+    }
+    case MSG_CONFLATED_TICK: {
+      auto& slot = tick_slots_[msg.ticker_index];
+      slot.pending.exchange(false, std::memory_order_acq_rel);
+
+      TickData tick;
+      slot.tick.load(&tick);
+      quote_pub_->publish(ContractTable::get_by_index(tick.ticker_index),
+                          &tick);
+      break;
+    }
+    case MSG_ORDER_RSP: {
+      rsp_pub_->publish(msg.order_rsp.strategy_id, &msg.order_rsp.rsp);
+      break;
+    }
+    default: {
+      spdlog::error("[AsyncPublisher::handle] Unknown message type {}",
+                    msg.type);
+      break;
+    }
+  }
+}
+
+}  // namespace ft
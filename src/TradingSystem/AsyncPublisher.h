@@ -0,0 +1,100 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_TRADINGSYSTEM_ASYNCPUBLISHER_H_
+#define FT_SRC_TRADINGSYSTEM_ASYNCPUBLISHER_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "Common/OrderRspTransport.h"
+#include "Common/QuoteTransport.h"
+#include "Core/Protocol.h"
+#include "Core/TickData.h"
+#include "IPC/MpscQueue.h"
+#include "IPC/SeqLock.h"
+
+namespace ft {
+
+/*
+ * 交易引擎的异步发布线程
+ *
+ * 网关回调线程只把行情和订单回报拷贝到有界无锁队列中就立即返回，由一个
+ * 单独的IO线程从队列中批量取出，交给实际的QuotePublisher/OrderRspPublisher
+ * 后一起flush(redis下即一次pipeline)，redis变慢时不会再阻塞CTP/XTP的
+ * 回调线程
+ *
+ * 队列满时行情按backpressure处理(见Constants.h)，订单回报总是等待，
+ * 不会被丢弃。conflate模式下行情先写入每个合约的最新行情槽位，队列中
+ * 只传递合约索引，IO线程发布时读取的总是该合约最新的行情
+ */
+class AsyncPublisher {
+ public:
+  AsyncPublisher(std::unique_ptr<QuotePublisher> quote_pub,
+                 std::unique_ptr<OrderRspPublisher> rsp_pub,
+                 const std::string& backpressure);
+
+  ~AsyncPublisher();
+
+  /*
+   * 返回的发布器把消息交给本对象异步发布，其生命周期不能超过本对象
+   */
+  std::unique_ptr<QuotePublisher> create_quote_publisher();
+  std::unique_ptr<OrderRspPublisher> create_rsp_publisher();
+
+  void publish_tick(const Contract* contract, const TickData* tick);
+
+  void publish_rsp(const std::string& strategy_id, const OrderResponse* rsp);
+
+  uint64_t dropped() const { return dropped_; }
+
+ private:
+  enum MsgType { MSG_TICK = 1, MSG_CONFLATED_TICK, MSG_ORDER_RSP };
+
+  struct Message {
+    Message() {}
+
+    uint32_t type;
+    union {
+      TickData tick;
+      uint32_t ticker_index;
+      struct {
+        StrategyIdType strategy_id;
+        OrderResponse rsp;
+      } order_rsp;
+    };
+  };
+
+  struct TickSlot {
+    SeqLocked<TickData> tick;
+    std::atomic<bool> pending{false};
+  };
+
+  static constexpr std::size_t kQueueSize = 4096;
+  static constexpr std::size_t kMaxBatch = 64;
+  static constexpr uint64_t kWaitTimeoutMs = 100;
+
+  void push(const Message& msg, bool can_drop);
+
+  void process();
+
+  void handle(const Message& msg);
+
+ private:
+  std::unique_ptr<QuotePublisher> quote_pub_;
+  std::unique_ptr<OrderRspPublisher> rsp_pub_;
+  std::string backpressure_;
+
+  std::unique_ptr<MpscQueue<Message, kQueueSize>> queue_;
+  std::unique_ptr<TickSlot[]> tick_slots_;
+  std::size_t tick_slot_count_ = 0;
+  std::atomic<uint64_t> dropped_{0};
+
+  std::atomic<bool> is_running_{false};
+  std::thread io_thread_;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_TRADINGSYSTEM_ASYNCPUBLISHER_H_
@@ -13,6 +13,23 @@
 
 namespace ft {
 
+inline ThrottleLimit load_throttle_limit(const YAML::Node& node,
+                                         const ThrottleLimit& default_limit) {
+  ThrottleLimit limit = default_limit;
+  if (!node) return limit;
+  limit.order_limit = node["order_limit"].as<uint64_t>(limit.order_limit);
+  limit.volume_limit = node["volume_limit"].as<uint64_t>(limit.volume_limit);
+  return limit;
+}
+
+inline void load_throttle_limits(
+    const YAML::Node& node, std::map<std::string, ThrottleLimit>* limits) {
+  if (!node) return;
+  for (const auto& item : node)
+    (*limits)[item.first.as<std::string>()] =
+        load_throttle_limit(item.second, ThrottleLimit{});
+}
+
 inline void load_config(const std::string& file, ft::Config* config) {
   std::ifstream ifs(file);
   assert(ifs);
@@ -37,6 +54,34 @@ inline void load_config(const std::string& file, ft::Config* config) {
   config->cancel_outstanding_orders_on_startup =
       node["cancel_outstanding_orders_on_startup"].as<bool>(true);
 
+  config->ipc_transport = node["ipc_transport"].as<std::string>("redis");
+  config->ipc_futex_wait = node["ipc_futex_wait"].as<bool>(false);
+  config->engine_cpu_affinity = node["engine_cpu_affinity"].as<int>(-1);
+  config->position_flush_interval_ms =
+      node["position_flush_interval_ms"].as<uint64_t>(0);
+  config->pnl_publish_interval_ms =
+      node["pnl_publish_interval_ms"].as<uint64_t>(500);
+  config->async_publish = node["async_publish"].as<bool>(false);
+  config->publish_backpressure =
+      node["publish_backpressure"].as<std::string>("block");
+  config->event_log_file = node["event_log_file"].as<std::string>("");
+  config->latency_trace = node["latency_trace"].as<bool>(false);
+
+  config->throttle_period_ms = node["throttle_period_ms"].as<uint64_t>(1000);
+  config->account_throttle =
+      load_throttle_limit(node["account_throttle"], config->account_throttle);
+  config->strategy_throttle = load_throttle_limit(node["strategy_throttle"],
+                                                  config->strategy_throttle);
+  load_throttle_limits(node["strategy_throttles"],
+                       &config->strategy_throttles);
+  config->ticker_throttle =
+      load_throttle_limit(node["ticker_throttle"], config->ticker_throttle);
+  load_throttle_limits(node["ticker_throttles"], &config->ticker_throttles);
+
+  config->price_band_ticks = node["price_band_ticks"].as<uint32_t>(0);
+  config->max_order_notional = node["max_order_notional"].as<double>(0);
+  config->max_ticker_notional = node["max_ticker_notional"].as<double>(0);
+
   config->arg0 = node["arg0"].as<std::string>("");
   config->arg1 = node["arg1"].as<std::string>("");
   config->arg2 = node["arg2"].as<std::string>("");
@@ -0,0 +1,314 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#include "TradingSystem/EventLogger.h"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/Metrics.h"
+#include "Core/Constants.h"
+#include "Core/ErrorCode.h"
+#include "Core/Protocol.h"
+
+namespace ft {
+
+namespace {
+
+constexpr std::size_t kRingSize = 4096;
+constexpr uint64_t kIdleSleepMs = 1;
+
+/*
+ * 每个写日志的线程独占一个，只有后台线程读取
+ */
+struct Ring {
+  alignas(64) std::atomic<uint64_t> head{0};  // 下一个写入位置
+  alignas(64) std::atomic<uint64_t> tail{0};  // 下一个读取位置
+  EventLogger::Record records[kRingSize];
+};
+
+std::mutex rings_mutex;
+std::vector<std::unique_ptr<Ring>> rings;
+thread_local Ring* tls_ring = nullptr;
+
+std::atomic<bool> is_running{false};
+std::atomic<uint64_t> dropped_count{0};
+std::thread writer;
+FILE* log_file = nullptr;
+
+class RecordReader {
+ public:
+  explicit RecordReader(const EventLogger::Record& rec) : rec_(rec) {}
+
+  int64_t i(std::size_t n) const { return static_cast<int64_t>(rec_.args[n]); }
+
+  double d(std::size_t n) const {
+    double value;
+    memcpy(&value, &rec_.args[n], sizeof(value));
+    return value;
+  }
+
+  const std::string& ticker(std::size_t n) const {
+    return reinterpret_cast<const Contract*>(rec_.args[n])->ticker;
+  }
+
+  const std::string& direction(std::size_t n) const {
+    return direction_str(rec_.args[n]);
+  }
+
+  const std::string& offset(std::size_t n) const {
+    return offset_str(rec_.args[n]);
+  }
+
+ private:
+  const EventLogger::Record& rec_;
+};
+
+const char* cmd_type_str(int64_t type) {
+  switch (type) {
+    case NEW_ORDER:
+      return "new order";
+    case NEW_ORDER_BATCH:
+      return "new order batch";
+    case CANCEL_ORDER:
+      return "cancel order";
+    case REPLACE_ORDER:
+      return "replace order";
+    case CANCEL_TICKER:
+      return "cancel all for ticker";
+    case CANCEL_ALL:
+      return "cancel all";
+    case CANCEL_STRATEGY:
+      return "cancel all for strategy";
+    case QUERY_ORDERS:
+      return "query orders";
+    default:
+      return "unknown cmd";
+  }
+}
+
+/*
+ * 各事件的参数依次为：
+ * LOG_CMD: cmd_type
+ * LOG_BATCH_SENT: sent, count
+ * LOG_RISK_REJECTED: contract, engine_order_id, user_order_id, error_code
+ * LOG_ORDER_SENT: contract, order_id, engine_order_id, strategy_index,
+ *                 user_order_id, direction, offset, type, volume, price
+ * LOG_ORDER_SEND_FAILED: contract, engine_order_id, direction, offset, type,
+ *                        volume, price
+ * LOG_ORDER_ACCEPTED/LOG_ORDER_REJECTED: contract, order_id, direction,
+ *                                        offset, volume, price
+ * LOG_ORDER_TRADED: contract, order_id, direction, offset, this_traded,
+ *                   traded_price
+ * LOG_ORDER_CANCELED: contract, order_id, direction, offset, canceled
+ * LOG_ORDER_COMPLETED: contract, order_id, direction, offset, traded, volume
+ * LOG_ORDER_REPLACED: contract, order_id, direction, offset, old_price,
+ *                     new_price, volume
+ * LOG_ACCOUNT: balance, frozen, margin
+ */
+std::string format_message(const EventLogger::Record& rec) {
+  RecordReader r(rec);
+
+  switch (rec.id) {
+    case LOG_CMD:
+      return fmt::format("[TradingEngine::process_cmd] {}",
+                         cmd_type_str(r.i(0)));
+    case LOG_BATCH_SENT:
+      return fmt::format(
+          "[TradingEngine::send_order_batch] {}/{} orders sent", r.i(0),
+          r.i(1));
+    case LOG_RISK_REJECTED:
+      return fmt::format(
+          "[TradingEngine::send_order] 风控未通过. Ticker: {}, "
+          "EngineOrderID: {}, UserOrderID: {}, Error: {}",
+          r.ticker(0), r.i(1), r.i(2), error_code_str(r.i(3)));
+    case LOG_ORDER_SENT:
+      return fmt::format(
+          "[TradingEngine::send_order] Success. Order: <Ticker: {}, "
+          "OrderID: {}, EngineOrderID: {}, Strategy: {}, UserOrderID: {}, "
+          "Direction: {}, Offset: {}, OrderType: {}, Total: {}, "
+          "Price: {:.2f}>",
+          r.ticker(0), r.i(1), r.i(2), r.i(3), r.i(4), r.direction(5),
+          r.offset(6), ordertype_str(r.i(7)), r.i(8), r.d(9));
+    case LOG_ORDER_SEND_FAILED:
+      return fmt::format(
+          "[TradingEngine::send_order] Failed to send_order. Order: <Ticker: "
+          "{}, EngineOrderID: {}, Direction: {}, Offset: {}, OrderType: {}, "
+          "Total: {}, Price: {:.2f}>",
+          r.ticker(0), r.i(1), r.direction(2), r.offset(3),
+          ordertype_str(r.i(4)), r.i(5), r.d(6));
+    case LOG_ORDER_ACCEPTED:
+      return fmt::format(
+          "[TradingEngine::on_order_accepted] 报单委托成功. Ticker: {}, "
+          "OrderID: {}, Direction: {}, Offset: {}, Volume: {}, Price: {:.2f}",
+          r.ticker(0), r.i(1), r.direction(2), r.offset(3), r.i(4), r.d(5));
+    case LOG_ORDER_REJECTED:
+      return fmt::format(
+          "[TradingEngine::on_order_rejected] 报单被拒. Ticker: {}, "
+          "OrderID: {}, Direction: {}, Offset: {}, Volume: {}, Price: {:.2f}",
+          r.ticker(0), r.i(1), r.direction(2), r.offset(3), r.i(4), r.d(5));
+    case LOG_ORDER_TRADED:
+      return fmt::format(
+          "[TradingEngine::on_order_traded] 报单成交. Ticker: {}, OrderID: {}, "
+          "Direction: {}, Offset: {}, Traded: {}, Price: {}",
+          r.ticker(0), r.i(1), r.direction(2), r.offset(3), r.i(4), r.d(5));
+    case LOG_ORDER_CANCELED:
+      return fmt::format(
+          "[TradingEngine::on_order_canceled] 报单已撤. Ticker: {}, "
+          "OrderID: {}, Direction: {}, Offset: {}, Canceled: {}",
+          r.ticker(0), r.i(1), r.direction(2), r.offset(3), r.i(4));
+    case LOG_ORDER_COMPLETED:
+      return fmt::format(
+          "[TradingEngine::on_order_completed] 报单完成. Ticker: {}, "
+          "OrderID: {}, Direction: {}, Offset: {}, Traded/Original: {}/{}",
+          r.ticker(0), r.i(1), r.direction(2), r.offset(3), r.i(4), r.i(5));
+    case LOG_ORDER_REPLACED:
+      return fmt::format(
+          "[TradingEngine::on_order_canceled] 改单. Ticker: {}, OrderID: {}, "
+          "Direction: {}, Offset: {}, Price: {:.2f} -> {:.2f}, Volume: {}",
+          r.ticker(0), r.i(1), r.direction(2), r.offset(3), r.d(4), r.d(5),
+          r.i(6));
+    case LOG_ACCOUNT:
+      return fmt::format("Account: balance:{} frozen:{} margin:{}", r.d(0),
+                         r.d(1), r.d(2));
+    default:
+      return fmt::format("Unknown event {}", rec.id);
+  }
+}
+
+/*
+ * 交给spdlog输出时各事件的日志级别，与这些日志原先在交易引擎中的级别
+ * 一致。写入日志文件时不区分级别
+ */
+spdlog::level::level_enum event_level(uint32_t id) {
+  switch (id) {
+    case LOG_RISK_REJECTED:
+    case LOG_ORDER_SEND_FAILED:
+    case LOG_ORDER_REJECTED:
+      return spdlog::level::err;
+    case LOG_ORDER_SENT:
+    case LOG_ACCOUNT:
+      return spdlog::level::debug;
+    default:
+      return spdlog::level::info;
+  }
+}
+
+void write_record(const EventLogger::Record& rec) {
+  if (!log_file) {
+    auto level = event_level(rec.id);
+    if (!spdlog::default_logger_raw()->should_log(level)) return;
+    spdlog::log(level, "{}", format_message(rec));
+    return;
+  }
+
+  auto msg = format_message(rec);
+
+  time_t sec = rec.time_ns / 1000000000ULL;
+  struct tm tm;
+  localtime_r(&sec, &tm);
+  char ts[32];
+  strftime(ts, sizeof(ts), "%Y-%m-%d %H:%M:%S", &tm);
+  fmt::print(log_file, "[{}.{:09d}] {}\n", ts, rec.time_ns % 1000000000ULL,
+             msg);
+}
+
+/*
+ * 输出所有线程缓冲区中的事件，返回输出的事件数
+ */
+std::size_t drain() {
+  std::vector<Ring*> snapshot;
+  {
+    std::unique_lock<std::mutex> lock(rings_mutex);
+    for (auto& ring : rings) snapshot.emplace_back(ring.get());
+  }
+
+  std::size_t count = 0;
+  for (auto ring : snapshot) {
+    uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail, ++count)
+      write_record(ring->records[tail & (kRingSize - 1)]);
+    ring->tail.store(tail, std::memory_order_release);
+  }
+
+  if (count > 0 && log_file) fflush(log_file);
+  return count;
+}
+
+void process() {
+  for (;;) {
+    bool running = is_running.load(std::memory_order_acquire);
+    if (drain() > 0) continue;
+    if (!running) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(kIdleSleepMs));
+  }
+}
+
+}  // namespace
+
+bool EventLogger::start(const std::string& file) {
+  if (is_running) return true;
+
+  if (!file.empty()) {
+    log_file = fopen(file.c_str(), "a");
+    if (!log_file) {
+      spdlog::error("[EventLogger::start] Failed to open {}", file);
+      return false;
+    }
+  }
+
+  is_running = true;
+  writer = std::thread(process);
+  return true;
+}
+
+void EventLogger::stop() {
+  if (!is_running) return;
+
+  is_running = false;
+  if (writer.joinable()) writer.join();
+  if (log_file) {
+    fclose(log_file);
+    log_file = nullptr;
+  }
+
+  auto dropped_events = dropped();
+  if (dropped_events > 0)
+    spdlog::warn("[EventLogger::stop] {} events dropped", dropped_events);
+  else
+    spdlog::info("[EventLogger::stop] No event dropped");
+}
+
+uint64_t EventLogger::dropped() { return dropped_count; }
+
+EventLogger::Record* EventLogger::begin_record() {
+  if (!is_running.load(std::memory_order_relaxed)) return nullptr;
+
+  if (!tls_ring) {
+    auto ring = std::make_unique<Ring>();
+    tls_ring = ring.get();
+    std::unique_lock<std::mutex> lock(rings_mutex);
+    rings.emplace_back(std::move(ring));
+  }
+
+  uint64_t head = tls_ring->head.load(std::memory_order_relaxed);
+  if (head - tls_ring->tail.load(std::memory_order_acquire) >= kRingSize) {
+    dropped_count.fetch_add(1, std::memory_order_relaxed);
+    Metrics::add(MC_LOG_DROPPED);
+    return nullptr;
+  }
+  return &tls_ring->records[head & (kRingSize - 1)];
+}
+
+void EventLogger::commit_record() {
+  uint64_t head = tls_ring->head.load(std::memory_order_relaxed);
+  tls_ring->head.store(head + 1, std::memory_order_release);
+}
+
+}  // namespace ft
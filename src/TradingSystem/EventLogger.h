@@ -0,0 +1,116 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_TRADINGSYSTEM_EVENTLOGGER_H_
+#define FT_SRC_TRADINGSYSTEM_EVENTLOGGER_H_
+
+#include <time.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "Core/Contract.h"
+
+namespace ft {
+
+/*
+ * 事件ID，每个ID的参数及输出格式见EventLogger.cpp
+ */
+enum EventLogId : uint32_t {
+  LOG_CMD = 1,
+  LOG_BATCH_SENT,
+  LOG_RISK_REJECTED,
+  LOG_ORDER_SENT,
+  LOG_ORDER_SEND_FAILED,
+  LOG_ORDER_ACCEPTED,
+  LOG_ORDER_REJECTED,
+  LOG_ORDER_TRADED,
+  LOG_ORDER_CANCELED,
+  LOG_ORDER_COMPLETED,
+  LOG_ORDER_REPLACED,
+  LOG_ACCOUNT,
+};
+
+/*
+ * 交易引擎热路径上的二进制事件日志
+ *
+ * 调用线程只把事件ID、时间戳和原始参数写入本线程独占的单写单读环形
+ * 缓冲区，不做任何格式化；后台线程轮询所有线程的缓冲区，按事件ID对应
+ * 的格式生成文本后写入日志文件，未指定文件时交给spdlog输出。缓冲区满时
+ * 丢弃事件并计数，不会阻塞调用线程
+ *
+ * 参数只能是整数、浮点数和Contract指针，Contract在进程的整个生命周期内
+ * 有效，后台线程格式化时再取合约代码
+ */
+class EventLogger {
+ public:
+  static constexpr std::size_t kMaxArgs = 14;
+
+  struct Record {
+    uint64_t time_ns;
+    uint32_t id;
+    uint32_t argc;
+    uint64_t args[kMaxArgs];
+  };
+
+  /*
+   * file为空时格式化后的事件交给spdlog输出
+   */
+  static bool start(const std::string& file);
+
+  /*
+   * 输出所有已记录的事件后退出后台线程
+   */
+  static void stop();
+
+  static uint64_t dropped();
+
+  template <class... Args>
+  static void log(EventLogId id, Args... args) {
+    static_assert(sizeof...(Args) <= kMaxArgs, "Too many args");
+
+    Record* rec = begin_record();
+    if (!rec) return;
+
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    rec->time_ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    rec->id = id;
+    rec->argc = sizeof...(Args);
+    std::size_t i = 0;
+    ((rec->args[i++] = to_arg(args)), ...);
+    commit_record();
+  }
+
+ private:
+  template <class T>
+  static uint64_t to_arg(T value) {
+    if constexpr (std::is_floating_point<T>::value) {
+      double d = value;
+      uint64_t bits;
+      memcpy(&bits, &d, sizeof(bits));
+      return bits;
+    } else if constexpr (std::is_pointer<T>::value) {
+      static_assert(std::is_same<T, const Contract*>::value,
+                    "Only Contract pointer is allowed");
+      return reinterpret_cast<uintptr_t>(value);
+    } else {
+      static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                    "Unsupported arg type");
+      return static_cast<uint64_t>(static_cast<int64_t>(value));
+    }
+  }
+
+  /*
+   * 返回本线程缓冲区中下一个可写的记录，缓冲区满或日志未启动时返回nullptr
+   */
+  static Record* begin_record();
+
+  static void commit_record();
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_TRADINGSYSTEM_EVENTLOGGER_H_
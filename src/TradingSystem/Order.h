@@ -22,20 +22,35 @@ enum class OrderStatus {
   CANCEL_REJECTED
 };
 
+/*
+ * 只包含POD字段，可以直接放在OrderStore的定长数组中
+ */
 struct Order {
   const Contract* contract;
+  uint64_t order_id;  // 网关返回的订单号
   uint64_t engine_order_id;
   uint32_t user_order_id;
   uint32_t type;
   uint32_t direction;
   uint32_t offset;
   double price = 0;
+  double margin_price = 0;  // 冻结保证金所用的价格，见AccountLedger
   int volume = 0;
   int traded_volume = 0;
   int canceled_volume = 0;
   OrderStatus status;
   uint64_t insert_time;
-  std::string strategy_id;
+  uint32_t strategy_index;  // 见StrategyIdTable，0表示不属于任何策略
+
+  // 延迟追踪用，策略发出指令的时间和网关发出订单的时间，0表示未追踪
+  uint64_t cmd_time_ns;
+  uint64_t sent_time_ns;
+
+  // 改单请求，原订单撤销完成后以这些参数发出新订单
+  bool replace_pending;
+  double replace_price;
+  int replace_volume;
+  uint32_t replace_user_order_id;
 };
 
 inline const std::string& to_string(OrderStatus s) {
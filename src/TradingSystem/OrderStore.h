@@ -0,0 +1,235 @@
+// Copyright [2020] <Copyright Kevin, kevin.lau.gd@gmail.com>
+
+#ifndef FT_SRC_TRADINGSYSTEM_ORDERSTORE_H_
+#define FT_SRC_TRADINGSYSTEM_ORDERSTORE_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "Common/StrategyIdTable.h"
+#include "TradingSystem/Order.h"
+
+namespace ft {
+
+/*
+ * 交易引擎的在途订单表，代替std::map<uint64_t, Order>
+ *
+ * 订单存放在启动时一次性分配好的定长数组中，空闲槽位组成一个空闲链表；
+ * 以网关返回的order_id为键的索引是一个开放寻址(线性探测)的哈希表，删除
+ * 时把后续元素前移而不留墓碑。订单的增删查都不会分配内存
+ *
+ * 每个在途订单同时挂在三个侵入式双向链表上：全部在途订单、同一合约的
+ * 在途订单、同一策略的在途订单。按合约或按策略批量撤单时只访问相关的
+ * 订单，不需要扫描整个订单表
+ *
+ * 只能在引擎线程中访问
+ */
+class OrderStore {
+ public:
+  static constexpr uint32_t kNull = UINT32_MAX;
+  static constexpr uint32_t kMaxTickers = 16384;
+
+  /*
+   * capacity为最多同时在途的订单数
+   */
+  explicit OrderStore(uint32_t capacity) : capacity_(capacity) {
+    slots_ = std::make_unique<Slot[]>(capacity_);
+    for (uint32_t i = 0; i < capacity_; ++i)
+      slots_[i].links[LIST_ALL].next = i + 1 < capacity_ ? i + 1 : kNull;
+    free_head_ = capacity_ > 0 ? 0 : kNull;
+
+    ticker_heads_ = std::make_unique<uint32_t[]>(kMaxTickers);
+    for (uint32_t i = 0; i < kMaxTickers; ++i) ticker_heads_[i] = kNull;
+    for (auto& head : strategy_heads_) head = kNull;
+
+    // 装载因子不超过0.5
+    bucket_bits_ = 1;
+    while ((1ULL << bucket_bits_) < 2ULL * capacity_) ++bucket_bits_;
+    bucket_mask_ = (1ULL << bucket_bits_) - 1;
+    buckets_ = std::make_unique<Bucket[]>(bucket_mask_ + 1);
+  }
+
+  uint32_t size() const { return size_; }
+
+  uint32_t capacity() const { return capacity_; }
+
+  bool full() const { return free_head_ == kNull; }
+
+  static bool is_valid_index(uint32_t ticker_index) {
+    return ticker_index < kMaxTickers;
+  }
+
+  /*
+   * 插入一个新订单，返回的订单中只设置了order_id、contract和
+   * strategy_index，其余字段由调用者填写，这三个字段之后不能再修改。
+   * order_id为0、已存在或订单表已满时返回nullptr
+   */
+  Order* insert(uint64_t order_id, const Contract* contract,
+                uint32_t strategy_index) {
+    if (order_id == 0 || full()) return nullptr;
+    if (!is_valid_index(contract->index) ||
+        strategy_index >= StrategyIdTable::kMaxStrategies)
+      return nullptr;
+
+    uint64_t pos = bucket_of(order_id);
+    while (buckets_[pos].order_id != 0) {
+      if (buckets_[pos].order_id == order_id) return nullptr;
+      pos = (pos + 1) & bucket_mask_;
+    }
+
+    uint32_t index = free_head_;
+    auto& slot = slots_[index];
+    free_head_ = slot.links[LIST_ALL].next;
+
+    slot.order = Order{};
+    slot.order.order_id = order_id;
+    slot.order.contract = contract;
+    slot.order.strategy_index = strategy_index;
+    link(LIST_ALL, &live_head_, index);
+    link(LIST_TICKER, &ticker_heads_[contract->index], index);
+    link(LIST_STRATEGY, &strategy_heads_[strategy_index], index);
+
+    buckets_[pos].order_id = order_id;
+    buckets_[pos].slot = index;
+    ++size_;
+    return &slot.order;
+  }
+
+  Order* find(uint64_t order_id) {
+    uint64_t pos = find_bucket(order_id);
+    if (pos == kNotFound) return nullptr;
+    return &slots_[buckets_[pos].slot].order;
+  }
+
+  /*
+   * 删除后该订单的指针失效
+   */
+  void erase(uint64_t order_id) {
+    uint64_t pos = find_bucket(order_id);
+    if (pos == kNotFound) return;
+
+    uint32_t index = buckets_[pos].slot;
+    erase_bucket(pos);
+
+    auto& order = slots_[index].order;
+    unlink(LIST_ALL, &live_head_, index);
+    unlink(LIST_TICKER, &ticker_heads_[order.contract->index], index);
+    unlink(LIST_STRATEGY, &strategy_heads_[order.strategy_index], index);
+
+    slots_[index].links[LIST_ALL].next = free_head_;
+    free_head_ = index;
+    --size_;
+  }
+
+  /*
+   * 以下遍历函数在遍历过程中都不能增删订单
+   */
+  template <class Func>
+  void for_each(Func&& func) {
+    for_each_in(LIST_ALL, live_head_, func);
+  }
+
+  template <class Func>
+  void for_each_of_ticker(uint32_t ticker_index, Func&& func) {
+    if (ticker_index >= kMaxTickers) return;
+    for_each_in(LIST_TICKER, ticker_heads_[ticker_index], func);
+  }
+
+  template <class Func>
+  void for_each_of_strategy(uint32_t strategy_index, Func&& func) {
+    if (strategy_index >= StrategyIdTable::kMaxStrategies) return;
+    for_each_in(LIST_STRATEGY, strategy_heads_[strategy_index], func);
+  }
+
+ private:
+  enum ListType { LIST_ALL = 0, LIST_TICKER, LIST_STRATEGY, LIST_COUNT };
+
+  struct Link {
+    uint32_t prev;
+    uint32_t next;
+  };
+
+  struct Slot {
+    Order order;
+    Link links[LIST_COUNT];
+  };
+
+  struct Bucket {
+    uint64_t order_id = 0;  // 0表示空桶
+    uint32_t slot = 0;
+  };
+
+  static constexpr uint64_t kNotFound = UINT64_MAX;
+
+  void link(ListType list, uint32_t* head, uint32_t index) {
+    auto& node = slots_[index].links[list];
+    node.prev = kNull;
+    node.next = *head;
+    if (*head != kNull) slots_[*head].links[list].prev = index;
+    *head = index;
+  }
+
+  void unlink(ListType list, uint32_t* head, uint32_t index) {
+    auto& node = slots_[index].links[list];
+    if (node.prev != kNull)
+      slots_[node.prev].links[list].next = node.next;
+    else
+      *head = node.next;
+    if (node.next != kNull) slots_[node.next].links[list].prev = node.prev;
+  }
+
+  template <class Func>
+  void for_each_in(ListType list, uint32_t head, Func&& func) {
+    for (uint32_t i = head; i != kNull; i = slots_[i].links[list].next)
+      func(slots_[i].order);
+  }
+
+  uint64_t bucket_of(uint64_t order_id) const {
+    // Fibonacci hashing，连续的order_id也能均匀分布
+    return (order_id * 0x9E3779B97F4A7C15ULL) >> (64 - bucket_bits_);
+  }
+
+  uint64_t find_bucket(uint64_t order_id) const {
+    if (order_id == 0) return kNotFound;
+
+    uint64_t pos = bucket_of(order_id);
+    while (buckets_[pos].order_id != 0) {
+      if (buckets_[pos].order_id == order_id) return pos;
+      pos = (pos + 1) & bucket_mask_;
+    }
+    return kNotFound;
+  }
+
+  /*
+   * 把后续同一探测序列中的元素前移填补空位，保证查找不会提前遇到空桶
+   */
+  void erase_bucket(uint64_t hole) {
+    uint64_t pos = (hole + 1) & bucket_mask_;
+    while (buckets_[pos].order_id != 0) {
+      uint64_t home = bucket_of(buckets_[pos].order_id);
+      if (((pos - home) & bucket_mask_) >= ((pos - hole) & bucket_mask_)) {
+        buckets_[hole] = buckets_[pos];
+        hole = pos;
+      }
+      pos = (pos + 1) & bucket_mask_;
+    }
+    buckets_[hole].order_id = 0;
+  }
+
+ private:
+  uint32_t capacity_;
+  uint32_t size_ = 0;
+  std::unique_ptr<Slot[]> slots_;
+  uint32_t free_head_ = kNull;
+  uint32_t live_head_ = kNull;
+  std::unique_ptr<uint32_t[]> ticker_heads_;
+  uint32_t strategy_heads_[StrategyIdTable::kMaxStrategies];
+
+  std::unique_ptr<Bucket[]> buckets_;
+  uint32_t bucket_bits_;
+  uint64_t bucket_mask_;
+};
+
+}  // namespace ft
+
+#endif  // FT_SRC_TRADINGSYSTEM_ORDERSTORE_H_
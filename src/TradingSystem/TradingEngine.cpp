@@ -2,23 +2,42 @@
 
 #include "TradingSystem/TradingEngine.h"
 
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include "Common/Metrics.h"
 #include "Core/ContractTable.h"
 #include "Core/ErrorCode.h"
 #include "Core/Protocol.h"
 #include "RiskManagement/RiskManager.h"
+#include "TradingSystem/EventLogger.h"
 #include "Utils/Misc.h"
 
 namespace ft {
 
 TradingEngine::TradingEngine()
     : portfolio_("127.0.0.1", 6379),
-      risk_mgr_(std::make_unique<RiskManager>(&portfolio_)) {}
+      event_queue_(std::make_unique<EventQueue>()) {
+  // 登录过程中就可能收到订单回调，入站队列须在登录前准备好
+  event_queue_->init();
+}
 
 TradingEngine::~TradingEngine() { close(); }
 
 bool TradingEngine::login(const Config& config) {
   if (is_logon_) return true;
 
+  if (!EventLogger::start(config.event_log_file)) {
+    spdlog::error("[TradingEngine::login] Failed to start event logger");
+    return false;
+  }
+
   gateway_.reset(create_gateway(config.api, this));
   if (!gateway_) {
     spdlog::error("[TradingEngine::login] Failed. Unknown gateway");
@@ -42,7 +61,14 @@ bool TradingEngine::login(const Config& config) {
 
   // query all positions
   spdlog::info("[[TradingEngine::login] Querying positions");
-  portfolio_.init(account_.account_id);
+  futex_wait_ = config.ipc_futex_wait;
+  pnl_interval_ms_ = config.pnl_publish_interval_ms;
+  cpu_affinity_ = config.engine_cpu_affinity;
+  latency_.set_enabled(config.latency_trace);
+  proto_.set_account(ledger_.account().account_id);
+  portfolio_.init(ledger_.account().account_id,
+                  config.position_flush_interval_ms);
+  ledger_.init(proto_.pos_shm_name());
   if (!gateway_->query_positions()) {
     spdlog::error("[TradingEngine::login] Failed to query positions");
     return false;
@@ -56,7 +82,59 @@ bool TradingEngine::login(const Config& config) {
   }
   spdlog::info("[[TradingEngine::login] Querying trades done");
 
-  proto_.set_account(account_.account_id);
+  if (!Metrics::open(proto_.metrics_shm_name()))
+    spdlog::warn("[TradingEngine::login] Failed to open {}",
+                 proto_.metrics_shm_name());
+
+  quote_pub_ = create_quote_publisher(config.ipc_transport, &proto_,
+                                      config.async_publish);
+  if (!quote_pub_) {
+    spdlog::error("[TradingEngine::login] Failed to create quote publisher");
+    return false;
+  }
+
+  rsp_pub_ = create_order_rsp_publisher(config.ipc_transport, &proto_,
+                                        config.async_publish);
+  if (!rsp_pub_) {
+    spdlog::error("[TradingEngine::login] Failed to create rsp publisher");
+    return false;
+  }
+
+  if (config.async_publish) {
+    const auto& backpressure = config.publish_backpressure;
+    if (backpressure != BACKPRESSURE_BLOCK &&
+        backpressure != BACKPRESSURE_DROP &&
+        backpressure != BACKPRESSURE_CONFLATE) {
+      spdlog::error("[TradingEngine::login] Unknown publish_backpressure: {}",
+                    backpressure);
+      return false;
+    }
+
+    async_pub_ = std::make_unique<AsyncPublisher>(
+        std::move(quote_pub_), std::move(rsp_pub_), backpressure);
+    quote_pub_ = async_pub_->create_quote_publisher();
+    rsp_pub_ = async_pub_->create_rsp_publisher();
+  }
+
+  quote_table_ = attach_shm_object<QuoteTable>(&quote_table_shm_,
+                                               proto_.quote_table_shm_name());
+  if (quote_table_)
+    quote_table_->clear();
+  else
+    spdlog::warn("[TradingEngine::login] Failed to open {}",
+                 proto_.quote_table_shm_name());
+
+  // 风控规则依赖配置和合约表，在开始接收策略指令之前创建
+  risk_mgr_ =
+      std::make_unique<RiskManager>(config, &portfolio_, &ledger_,
+                                    &strategy_ids_);
+
+  cmd_receiver_ = create_trader_cmd_receiver(
+      config.ipc_transport, config.ipc_futex_wait, &proto_);
+  if (!cmd_receiver_) {
+    spdlog::error("[TradingEngine::login] Failed to create cmd receiver");
+    return false;
+  }
   spdlog::info("[TradingEngine::login] Init done");
 
   is_logon_ = true;
@@ -64,156 +142,479 @@ bool TradingEngine::login(const Config& config) {
 }
 
 void TradingEngine::run() {
-  spdlog::info("[TradingEngine::run] Start to recv order req from topic: {}",
-               proto_.trader_cmd_topic());
+  if (cpu_affinity_ >= 0) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu_affinity_, &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0)
+      spdlog::error("[TradingEngine::run] Failed to bind engine thread to {}",
+                    cpu_affinity_);
+    else
+      spdlog::info("[TradingEngine::run] Engine thread bound to cpu {}",
+                   cpu_affinity_);
+  }
+
+  if (latency_.enabled()) install_latency_dump_handler();
 
-  order_redis_.subscribe({proto_.trader_cmd_topic()});
+  std::thread(&TradingEngine::recv_cmd, this).detach();
 
+  spdlog::info("[TradingEngine::run] Start to recv order req");
+
+  EngineEvent event;
   for (;;) {
-    auto reply = order_redis_.get_sub_reply();
-    if (!reply) continue;
+    if (latency_.enabled()) latency_.dump_if_requested("TradingEngine");
+    if (pnl_interval_ms_ > 0) mark_to_market_if_due();
 
-    auto cmd = reinterpret_cast<const TraderCommand*>(reply->element[2]->str);
-    if (cmd->magic != TRADER_CMD_MAGIC) {
-      spdlog::error("[TradingEngine::run] Recv unknown cmd: error magic num");
+    if (event_queue_->try_pop(&event)) {
+      process_event(event);
+      Metrics::set(MG_LIVE_ORDERS, orders_.size());
+      Metrics::set(MG_EVENT_QUEUE_DEPTH, event_queue_->size());
       continue;
     }
 
-    switch (cmd->type) {
-      case NEW_ORDER:
-        spdlog::info("new order");
-        send_order(cmd);
-        break;
-      case CANCEL_ORDER:
-        spdlog::info("cancel order");
-        cancel_order(cmd->cancel_req.order_id);
-        break;
-      case CANCEL_TICKER:
-        spdlog::info("cancel all for ticker");
-        cancel_for_ticker(cmd->cancel_ticker_req.ticker_index);
-        break;
-      case CANCEL_ALL:
-        spdlog::info("cancel all");
-        cancel_all();
-        break;
-      default:
-        spdlog::error("[StrategyEngine::run] Unknown cmd");
-        break;
+    if (futex_wait_)
+      event_queue_->wait(kWaitTimeoutMs);
+    else
+      cpu_relax();
+  }
+}
+
+/*
+ * 行情回调线程只记录最新价，浮动盈亏按周期在引擎线程中统一计算和发布
+ */
+void TradingEngine::mark_to_market_if_due() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  uint64_t now_ms = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+  if (now_ms < next_pnl_ms_) return;
+
+  next_pnl_ms_ = now_ms + pnl_interval_ms_;
+  portfolio_.mark_to_market();
+}
+
+/*
+ * 从策略接收交易指令并放入入站队列
+ */
+void TradingEngine::recv_cmd() {
+  // 批量报单的指令头和每笔订单各占一个事件，一起放入连续的槽位
+  auto events = std::make_unique<EngineEvent[]>(kMaxBatchOrders + 1);
+  events[0].type = EV_TRADER_CMD;
+  for (;;) {
+    auto cmd = cmd_receiver_->get_cmd();
+    if (!cmd) continue;
+
+    Metrics::add(MC_CMD_RECEIVED);
+    events[0].cmd = *cmd;
+    events[0].time_ns = latency_.now();
+    if (cmd->type != NEW_ORDER_BATCH) {
+      push_event(events[0]);
+      continue;
+    }
+
+    uint32_t count = cmd->order_batch.count;
+    auto reqs = batch_order_reqs(cmd);
+    for (uint32_t i = 0; i < count; ++i) {
+      events[i + 1].type = EV_BATCH_ORDER_REQ;
+      events[i + 1].time_ns = events[0].time_ns;
+      events[i + 1].order_req = reqs[i];
+    }
+    push_events(events.get(), count + 1);
+  }
+}
+
+/*
+ * 入站队列满时只能等待，订单事件不能丢弃
+ */
+void TradingEngine::push_event(const EngineEvent& event) {
+  while (!event_queue_->try_push(event)) cpu_relax();
+}
+
+void TradingEngine::push_events(const EngineEvent* events, std::size_t n) {
+  while (!event_queue_->try_push_n(events, n)) cpu_relax();
+}
+
+/*
+ * 批量报单的订单紧跟在指令头之后，写者已预留好槽位，自旋等待即可
+ */
+void TradingEngine::process_batch_cmd(const TraderCommand& cmd) {
+  batch_cmd_.cmd = cmd;
+
+  EngineEvent event;
+  for (uint32_t i = 0; i < cmd.order_batch.count; ++i) {
+    while (!event_queue_->try_pop(&event)) cpu_relax();
+    if (event.type != EV_BATCH_ORDER_REQ) {
+      spdlog::error("[TradingEngine::process_batch_cmd] Broken batch");
+      process_event(event);
+      return;
     }
+    batch_cmd_.order_reqs[i] = event.order_req;
+  }
+
+  process_cmd(&batch_cmd_.cmd);
+}
+
+void TradingEngine::process_event(const EngineEvent& event) {
+  event_time_ns_ = event.time_ns;
+  latency_.record(LAT_INBOUND_QUEUE, event_time_ns_, latency_.now());
+
+  switch (event.type) {
+    case EV_TRADER_CMD:
+      latency_.record(LAT_CMD_TRANSPORT, event.cmd.send_time_ns,
+                      event_time_ns_);
+      if (event.cmd.type == NEW_ORDER_BATCH)
+        process_batch_cmd(event.cmd);
+      else
+        process_cmd(&event.cmd);
+      break;
+    case EV_ORDER_ACCEPTED:
+      handle_order_accepted(event.order.order_id);
+      break;
+    case EV_ORDER_REJECTED:
+      handle_order_rejected(event.order.order_id);
+      break;
+    case EV_ORDER_TRADED:
+      handle_order_traded(event.order.order_id, event.order.volume,
+                          event.order.price);
+      break;
+    case EV_ORDER_CANCELED:
+      handle_order_canceled(event.order.order_id, event.order.volume);
+      break;
+    case EV_ORDER_CANCEL_REJECTED:
+      handle_order_cancel_rejected(event.order.order_id);
+      break;
+    default:
+      spdlog::error("[TradingEngine::process_event] Unknown event");
+      break;
+  }
+}
+
+void TradingEngine::process_cmd(const TraderCommand* cmd) {
+  if (cmd->magic != TRADER_CMD_MAGIC) {
+    spdlog::error("[TradingEngine::run] Recv unknown cmd: error magic num");
+    return;
+  }
+
+  EventLogger::log(LOG_CMD, cmd->type);
+
+  switch (cmd->type) {
+    case NEW_ORDER:
+      send_order(cmd);
+      break;
+    case NEW_ORDER_BATCH:
+      send_order_batch(cmd);
+      break;
+    case CANCEL_ORDER:
+      cancel_order(cmd->cancel_req.order_id);
+      break;
+    case REPLACE_ORDER:
+      replace_order(cmd);
+      break;
+    case CANCEL_TICKER:
+      cancel_for_ticker(cmd->cancel_ticker_req.ticker_index);
+      break;
+    case CANCEL_ALL:
+      cancel_all();
+      break;
+    case CANCEL_STRATEGY:
+      cancel_strategy(cmd->strategy_id);
+      break;
+    case QUERY_ORDERS:
+      query_orders(cmd->strategy_id);
+      break;
+    default:
+      spdlog::error("[StrategyEngine::run] Unknown cmd");
+      break;
   }
 }
 
 void TradingEngine::close() {
   if (gateway_) gateway_->logout();
+  EventLogger::stop();
 }
 
 bool TradingEngine::send_order(const TraderCommand* cmd) {
+  return send_orders(cmd, &cmd->order_req, 1) == 1;
+}
+
+void TradingEngine::send_order_batch(const TraderCommand* cmd) {
+  uint32_t count = cmd->order_batch.count;
+  if (count == 0 || count > kMaxBatchOrders) {
+    spdlog::error("[TradingEngine::send_order_batch] Invalid count {}", count);
+    return;
+  }
+
+  uint32_t sent = send_orders(cmd, batch_order_reqs(cmd), count);
+  EventLogger::log(LOG_BATCH_SENT, sent, count);
+}
+
+/*
+ * 单笔和批量报单共用的流程：先逐笔完成风控检查并冻结仓位和保证金，
+ * 同一批中后面的订单能看到前面订单的冻结；再把通过检查的订单一次交给
+ * 网关；最后登记发送成功的订单，发送失败的解冻。返回发送成功的订单数
+ */
+uint32_t TradingEngine::send_orders(const TraderCommand* cmd,
+                                    const TraderOrderReq* sreqs,
+                                    uint32_t count) {
   if (!is_logon_) {
     spdlog::error("[TradingEngine::send_order] Failed. Not logon");
-    return false;
+    return 0;
   }
 
-  auto& sreq = cmd->order_req;
-  auto contract = ContractTable::get_by_index(sreq.ticker_index);
-  if (!contract) {
-    spdlog::error("[TradingEngine::send_order] Contract not found");
-    return false;
+  uint64_t start_ns = latency_.now();
+  uint32_t strategy_index = strategy_ids_.intern(cmd->strategy_id);
+  if (cmd->strategy_id[0] != 0 && strategy_index == StrategyIdTable::kNone) {
+    spdlog::error("[TradingEngine::send_order] 策略数已达上限{}",
+                  StrategyIdTable::kMaxStrategies);
+    for (uint32_t i = 0; i < count; ++i)
+      respond_send_order_error(cmd, sreqs[i], ERR_SEND_FAILED);
+    return 0;
   }
 
-  OrderReq req;
-  req.engine_order_id = next_engine_order_id();
-  req.ticker_index = sreq.ticker_index;
-  req.direction = sreq.direction;
-  req.offset = sreq.offset;
-  req.volume = sreq.volume;
-  req.type = sreq.type;
-  req.price = sreq.price;
-
-  std::unique_lock<std::mutex> lock(mutex_);
-  int error_code = risk_mgr_->check_order_req(&req);
-  if (error_code != NO_ERROR) {
-    spdlog::error("[TradingEngine::send_order] 风控未通过: {}",
-                  error_code_str(error_code));
-    risk_mgr_->on_order_completed(req.engine_order_id, error_code);
-    respond_send_order_error(cmd, error_code);
-    return false;
-  }
+  uint32_t pending = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    auto& sreq = sreqs[i];
+    auto contract = ContractTable::get_by_index(sreq.ticker_index);
+    if (!contract) {
+      spdlog::error("[TradingEngine::send_order] Contract not found");
+      continue;
+    }
 
-  uint64_t order_id = gateway_->send_order(&req);
-  if (order_id == 0) {
-    spdlog::error(
-        "[StrategyEngine::send_order] Failed to send_order. Order: <Ticker: "
-        "{}, Direction: {}, Offset: {}, OrderType: {}, Traded: {}, Total: {}, "
-        "Price: {:.2f}, Status: Failed>",
-        contract->ticker, direction_str(req.direction), offset_str(req.offset),
-        ordertype_str(req.type), 0, req.volume, req.price);
-
-    risk_mgr_->on_order_completed(req.engine_order_id, ERR_SEND_FAILED);
-    respond_send_order_error(cmd, ERR_SEND_FAILED);
-    return false;
+    if (orders_.size() + pending >= orders_.capacity()) {
+      spdlog::error("[TradingEngine::send_order] 在途订单数已达上限{}",
+                    orders_.capacity());
+      respond_send_order_error(cmd, sreq, ERR_SEND_FAILED);
+      continue;
+    }
+
+    // 发出后无法登记的订单会在交易所成为孤儿单，须在发送前拒绝
+    if (!OrderStore::is_valid_index(contract->index)) {
+      spdlog::error("[TradingEngine::send_order] 合约下标{}超出订单表上限{}",
+                    contract->index, OrderStore::kMaxTickers);
+      respond_send_order_error(cmd, sreq, ERR_SEND_FAILED);
+      continue;
+    }
+
+    auto& req = pending_reqs_[pending];
+    req.engine_order_id = next_engine_order_id();
+    req.user_order_id = sreq.user_order_id;
+    req.strategy_index = strategy_index;
+    req.ticker_index = sreq.ticker_index;
+    req.direction = sreq.direction;
+    req.offset = sreq.offset;
+    req.volume = sreq.volume;
+    req.type = sreq.type;
+    req.price = sreq.price;
+
+    int error_code = risk_mgr_->check_order_req(&req);
+    if (error_code != NO_ERROR) {
+      EventLogger::log(LOG_RISK_REJECTED, contract, req.engine_order_id,
+                       req.user_order_id, error_code);
+      risk_mgr_->on_order_completed(req.engine_order_id, error_code);
+      respond_send_order_error(cmd, sreq, error_code);
+      continue;
+    }
+
+    double margin_price =
+        ledger_.margin_price(req.ticker_index, req.type, req.price);
+    freeze_order(contract, req, req.volume, margin_price);
+    pending_margin_prices_[pending] = margin_price;
+    pending_legs_[pending] = i;
+    ++pending;
   }
 
-  risk_mgr_->on_order_sent(req.engine_order_id);
+  if (pending == 0) return 0;
+
+  uint64_t checked_ns = latency_.now();
+  if (pending == 1)
+    pending_order_ids_[0] = gateway_->send_order(&pending_reqs_[0]);
+  else
+    gateway_->send_order_batch(pending_reqs_, pending, pending_order_ids_);
+
+  uint64_t sent_ns = latency_.now();
+  latency_.record(LAT_RISK_CHECK, start_ns, checked_ns);
+  latency_.record(LAT_GATEWAY_SEND, checked_ns, sent_ns);
+  latency_.record(LAT_STRATEGY_TO_GATEWAY, cmd->send_time_ns, sent_ns);
+
+  uint32_t sent = 0;
+  for (uint32_t k = 0; k < pending; ++k) {
+    auto& sreq = sreqs[pending_legs_[k]];
+    auto& req = pending_reqs_[k];
+    auto contract = ContractTable::get_by_index(req.ticker_index);
+    uint64_t order_id = pending_order_ids_[k];
+
+    if (order_id == 0) {
+      EventLogger::log(LOG_ORDER_SEND_FAILED, contract, req.engine_order_id,
+                       req.direction, req.offset, req.type, req.volume,
+                       req.price);
+
+      Metrics::add(MC_ORDER_SEND_FAILED);
+      freeze_order(contract, req, -req.volume, pending_margin_prices_[k]);
+      risk_mgr_->on_order_completed(req.engine_order_id, ERR_SEND_FAILED);
+      respond_send_order_error(cmd, sreq, ERR_SEND_FAILED);
+      continue;
+    }
 
-  Order order{};
-  order.contract = contract;
-  order.engine_order_id = req.engine_order_id;
-  order.user_order_id = sreq.user_order_id;
-  order.direction = sreq.direction;
-  order.offset = sreq.offset;
-  order.volume = sreq.volume;
-  order.type = sreq.type;
-  order.price = sreq.price;
-  order.status = OrderStatus::SUBMITTING;
-  order.strategy_id = cmd->strategy_id;
-  order_map_.emplace(order_id, order);
+    auto order_ptr = orders_.insert(order_id, contract, strategy_index);
+    if (!order_ptr) {
+      // 订单已到柜台但无法跟踪，撤掉它并当作发送失败处理，之后该订单
+      // 的回报会因找不到订单而被忽略
+      spdlog::error("[TradingEngine::send_order] Failed to track OrderID: {}",
+                    order_id);
+      gateway_->cancel_order(order_id);
+      Metrics::add(MC_ORDER_SEND_FAILED);
+      freeze_order(contract, req, -req.volume, pending_margin_prices_[k]);
+      risk_mgr_->on_order_completed(req.engine_order_id, ERR_SEND_FAILED);
+      respond_send_order_error(cmd, sreq, ERR_SEND_FAILED);
+      continue;
+    }
 
-  portfolio_.update_pending(contract->index, order.direction, order.offset,
-                            order.volume);
+    risk_mgr_->on_order_sent(req.engine_order_id);
+
+    auto& order = *order_ptr;
+    order.engine_order_id = req.engine_order_id;
+    order.user_order_id = req.user_order_id;
+    order.direction = req.direction;
+    order.offset = req.offset;
+    order.volume = req.volume;
+    order.type = req.type;
+    order.price = req.price;
+    order.margin_price = pending_margin_prices_[k];
+    order.status = OrderStatus::SUBMITTING;
+    order.cmd_time_ns = cmd->send_time_ns;
+    order.sent_time_ns = sent_ns;
+    ++sent;
+    Metrics::add(MC_ORDER_SENT);
+
+    EventLogger::log(LOG_ORDER_SENT, contract, order_id, req.engine_order_id,
+                     strategy_index, req.user_order_id, req.direction,
+                     req.offset, req.type, req.volume, req.price);
+  }
 
-  if (is_offset_open(order.offset)) {
-    auto margin_rate = order.direction == Direction::BUY
-                           ? contract->long_margin_rate
-                           : contract->short_margin_rate;
-    account_.frozen +=
-        contract->size * order.volume * order.price * margin_rate;
-    spdlog::debug("Account: balance:{} frozen:{} margin:{}", account_.balance,
-                  account_.frozen, account_.margin);
-  }
-
-  spdlog::debug(
-      "[StrategyEngine::send_order] Success. Order: <Ticker: {}, OrderID: {}, "
-      "Direction: {}, Offset: {}, OrderType: {}, Traded: {}, Total: {}, Price: "
-      "{:.2f}, Status: {}>",
-      contract->ticker, order_id, direction_str(order.direction),
-      offset_str(order.offset), ordertype_str(order.type), 0, order.volume,
-      order.price, to_string(order.status));
-  return true;
+  return sent;
+}
+
+/*
+ * 冻结(volume > 0)或解冻(volume < 0)订单占用的仓位和保证金
+ */
+void TradingEngine::freeze_order(const Contract* contract, const OrderReq& req,
+                                 int volume, double margin_price) {
+  portfolio_.update_pending(contract->index, req.direction, req.offset,
+                            volume);
+
+  if (is_offset_open(req.offset)) {
+    ledger_.freeze(contract, req.direction, req.offset, volume, margin_price);
+    log_account();
+  }
+}
+
+void TradingEngine::log_account() {
+  const auto& account = ledger_.account();
+  EventLogger::log(LOG_ACCOUNT, account.balance, account.frozen,
+                   account.margin);
 }
 
 void TradingEngine::cancel_order(uint64_t order_id) {
   gateway_->cancel_order(order_id);
 }
 
-void TradingEngine::cancel_for_ticker(uint32_t ticker_index) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  for (const auto& [order_id, order] : order_map_) {
-    if (ticker_index == order.contract->index) gateway_->cancel_order(order_id);
+/*
+ * 改单只记录在原订单上并发出撤单，撤单完成后由handle_order_canceled发出
+ * 新订单。原订单上已有未完成的改单请求时以最新的请求为准
+ */
+void TradingEngine::replace_order(const TraderCommand* cmd) {
+  auto& rreq = cmd->replace_req;
+  auto order = orders_.find(rreq.order_id);
+  if (!order) {
+    spdlog::error("[TradingEngine::replace_order] Order not found. OrderID: {}",
+                  rreq.order_id);
+    return;
   }
+
+  // 匿名订单的strategy_index为kNone，不能被任何策略修改
+  auto strategy_index = strategy_ids_.find(cmd->strategy_id);
+  if (strategy_index == StrategyIdTable::kNone ||
+      order->strategy_index != strategy_index) {
+    spdlog::error(
+        "[TradingEngine::replace_order] 只能修改本策略的订单. OrderID: {}",
+        rreq.order_id);
+    return;
+  }
+
+  bool cancel_sent = order->replace_pending;
+  order->replace_pending = true;
+  order->replace_price = rreq.price;
+  order->replace_volume = rreq.volume;
+  order->replace_user_order_id = rreq.user_order_id;
+  if (cancel_sent) return;
+
+  if (!gateway_->cancel_order(rreq.order_id)) {
+    spdlog::error(
+        "[TradingEngine::replace_order] Failed to cancel. OrderID: {}",
+        rreq.order_id);
+    order->replace_pending = false;
+  }
+}
+
+void TradingEngine::cancel_for_ticker(uint32_t ticker_index) {
+  orders_.for_each_of_ticker(ticker_index, [&](const Order& order) {
+    gateway_->cancel_order(order.order_id);
+  });
+}
+
+void TradingEngine::cancel_strategy(const char* strategy_id) {
+  uint32_t strategy_index = strategy_ids_.find(strategy_id);
+  if (strategy_index == StrategyIdTable::kNone) return;
+
+  orders_.for_each_of_strategy(strategy_index, [&](const Order& order) {
+    gateway_->cancel_order(order.order_id);
+  });
 }
 
 void TradingEngine::cancel_all() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  for (const auto& [order_id, order] : order_map_) {
-    UNUSED(order);
-    gateway_->cancel_order(order_id);
+  orders_.for_each(
+      [&](const Order& order) { gateway_->cancel_order(order.order_id); });
+}
+
+/*
+ * 推送策略的未完成订单快照，没有未完成订单(包括从未报过单)的策略也会
+ * 收到结束标记
+ */
+void TradingEngine::query_orders(const char* strategy_id) {
+  if (strategy_id[0] == 0) return;
+
+  std::string name(strategy_id, strnlen(strategy_id, sizeof(StrategyIdType)));
+  uint32_t strategy_index = strategy_ids_.find(strategy_id);
+  uint32_t count = 0;
+  if (strategy_index != StrategyIdTable::kNone) {
+    orders_.for_each_of_strategy(strategy_index, [&](const Order& order) {
+      OrderResponse rsp{};
+      rsp.user_order_id = order.user_order_id;
+      rsp.order_id = order.order_id;
+      rsp.ticker_index = order.contract->index;
+      rsp.direction = order.direction;
+      rsp.offset = order.offset;
+      rsp.original_volume = order.volume;
+      rsp.traded_volume = order.traded_volume;
+      rsp.completed = false;
+      rsp.error_code = NO_ERROR;
+      rsp.snapshot = true;
+      publish_rsp(name, &rsp);
+      ++count;
+    });
   }
+
+  OrderResponse end{};
+  end.error_code = NO_ERROR;
+  end.snapshot = true;
+  end.snapshot_end = true;
+  end.snapshot_count = count;
+  publish_rsp(name, &end);
 }
 
 void TradingEngine::on_query_contract(const Contract* contract) {}
 
 void TradingEngine::on_query_account(const Account* account) {
-  account_ = *account;
+  ledger_.set_account(*account);
   spdlog::info(
       "[TradingEngine::on_query_account] Account ID: {}, Balance: {}, Fronzen: "
       "{}",
@@ -243,12 +644,10 @@ void TradingEngine::on_query_position(const Position* position) {
 
   portfolio_.set_position(position);
 
-  account_.margin +=
-      contract->size *
-      (lp.holdings * lp.cost_price * contract->long_margin_rate +
-       sp.holdings * sp.cost_price * contract->short_margin_rate);
-  spdlog::debug("Account: balance:{} frozen:{} margin:{}", account_.balance,
-                account_.frozen, account_.margin);
+  ledger_.add_position(contract, *position);
+  const auto& account = ledger_.account();
+  spdlog::debug("Account: balance:{} frozen:{} margin:{}", account.balance,
+                account.frozen, account.margin);
 }
 
 void TradingEngine::on_tick(const TickData* tick) {
@@ -260,8 +659,12 @@ void TradingEngine::on_tick(const TickData* tick) {
     return;
   }
 
-  tick_redis_.publish(proto_.quote_key(contract->ticker), tick,
-                      sizeof(TickData));
+  risk_mgr_->on_tick(tick);
+  ledger_.mark_price(tick->ticker_index, tick->last_price);
+  if (quote_table_) quote_table_->update(*tick);
+  quote_pub_->publish(contract, tick);
+  if (pnl_interval_ms_ > 0)
+    portfolio_.mark_price(tick->ticker_index, tick->last_price);
   spdlog::debug("[TradingEngine::process_tick] ask:{:.3f}  bid:{:.3f}",
                 tick->ask[0], tick->bid[0]);
 }
@@ -276,152 +679,173 @@ void TradingEngine::on_query_trade(const Trade* trade) {
                                    trade->offset, trade->volume);
 }
 
+void TradingEngine::on_order_accepted(uint64_t order_id) {
+  EngineEvent event;
+  event.type = EV_ORDER_ACCEPTED;
+  event.time_ns = latency_.now();
+  event.order.order_id = order_id;
+  push_event(event);
+}
+
+void TradingEngine::on_order_rejected(uint64_t order_id) {
+  EngineEvent event;
+  event.type = EV_ORDER_REJECTED;
+  event.time_ns = latency_.now();
+  event.order.order_id = order_id;
+  push_event(event);
+}
+
+void TradingEngine::on_order_traded(uint64_t order_id, int this_traded,
+                                    double traded_price) {
+  EngineEvent event;
+  event.type = EV_ORDER_TRADED;
+  event.time_ns = latency_.now();
+  event.order.order_id = order_id;
+  event.order.volume = this_traded;
+  event.order.price = traded_price;
+  push_event(event);
+}
+
+void TradingEngine::on_order_canceled(uint64_t order_id, int canceled_volume) {
+  EngineEvent event;
+  event.type = EV_ORDER_CANCELED;
+  event.time_ns = latency_.now();
+  event.order.order_id = order_id;
+  event.order.volume = canceled_volume;
+  push_event(event);
+}
+
+void TradingEngine::on_order_cancel_rejected(uint64_t order_id) {
+  EngineEvent event;
+  event.type = EV_ORDER_CANCEL_REJECTED;
+  event.time_ns = latency_.now();
+  event.order.order_id = order_id;
+  push_event(event);
+}
+
 /*
  * 订单被市场接受后通知策略
  * 告知策略order_id，策略可通过此order_id撤单
  */
-void TradingEngine::on_order_accepted(uint64_t order_id) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(order_id);
-  if (iter == order_map_.end()) {
+void TradingEngine::handle_order_accepted(uint64_t order_id) {
+  Metrics::add(MC_ORDER_ACCEPTED);
+
+  auto order_ptr = orders_.find(order_id);
+  if (!order_ptr) {
     spdlog::error(
         "[TradingEngine::on_order_accepted] Order not found. OrderID: {}",
         order_id);
     return;
   }
 
-  auto& order = iter->second;
-  if (order.strategy_id[0] != 0) {
+  auto& order = *order_ptr;
+  latency_.record(LAT_EXCHANGE_ACK, order.sent_time_ns, event_time_ns_);
+
+  if (order.strategy_index != StrategyIdTable::kNone) {
     OrderResponse rsp{};
     rsp.user_order_id = order.user_order_id;
     rsp.order_id = order_id;
+    rsp.cmd_time_ns = order.cmd_time_ns;
     rsp.ticker_index = order.contract->index;
     rsp.direction = order.direction;
     rsp.offset = order.offset;
     rsp.original_volume = order.volume;
     rsp.error_code = NO_ERROR;
-    rsp_redis_.publish(order.strategy_id, &rsp, sizeof(rsp));
+    publish_rsp(strategy_ids_.name(order.strategy_index), &rsp);
   }
 
-  spdlog::info(
-      "[TradingEngine::on_order_accepted] 报单委托成功. Ticker: {}, Direction: "
-      "{}, Offset: {}, Volume: {}, Price: {:.2f}",
-      order.contract->ticker, direction_str(order.direction),
-      offset_str(order.offset), order.volume, order.price);
+  EventLogger::log(LOG_ORDER_ACCEPTED, order.contract, order_id,
+                   order.direction, order.offset, order.volume, order.price);
 }
 
-void TradingEngine::on_order_rejected(uint64_t order_id) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(order_id);
-  if (iter == order_map_.end()) {
+void TradingEngine::handle_order_rejected(uint64_t order_id) {
+  Metrics::add(MC_ORDER_REJECTED);
+
+  auto order_ptr = orders_.find(order_id);
+  if (!order_ptr) {
     spdlog::error(
         "[TradingEngine::on_order_rejected] Order not found. OrderID: {}",
         order_id);
     return;
   }
 
-  auto& order = iter->second;
+  auto& order = *order_ptr;
   portfolio_.update_pending(order.contract->index, order.direction,
                             order.offset, -order.volume);
 
   if (is_offset_open(order.offset)) {
-    auto margin_rate = order.direction == Direction::BUY
-                           ? order.contract->long_margin_rate
-                           : order.contract->short_margin_rate;
-    account_.frozen -=
-        order.contract->size * order.volume * order.price * margin_rate;
-    spdlog::debug("Account: balance:{} frozen:{} margin:{}", account_.balance,
-                  account_.frozen, account_.margin);
+    ledger_.freeze(order.contract, order.direction, order.offset,
+                   -order.volume, order.margin_price);
+    log_account();
   }
 
   risk_mgr_->on_order_completed(order.engine_order_id, ERR_REJECTED);
 
-  if (order.strategy_id[0] != 0) {
+  if (order.strategy_index != StrategyIdTable::kNone) {
     OrderResponse rsp{};
     rsp.user_order_id = order.user_order_id;
     rsp.order_id = order_id;
+    rsp.cmd_time_ns = order.cmd_time_ns;
     rsp.ticker_index = order.contract->index;
     rsp.direction = order.direction;
     rsp.offset = order.offset;
     rsp.original_volume = order.volume;
     rsp.completed = true;
     rsp.error_code = ERR_REJECTED;
-    rsp_redis_.publish(order.strategy_id, &rsp, sizeof(rsp));
+    publish_rsp(strategy_ids_.name(order.strategy_index), &rsp);
   }
 
-  spdlog::error(
-      "[TradingEngine::on_order_rejected] 报单被拒. Ticker: {}, Direction: "
-      "{}, Offset: {}, Volume: {}, Price: {:.2f}",
-      order.contract->ticker, direction_str(order.direction),
-      offset_str(order.offset), order.volume, order.price);
+  EventLogger::log(LOG_ORDER_REJECTED, order.contract, order_id,
+                   order.direction, order.offset, order.volume, order.price);
 
-  order_map_.erase(iter);
+  orders_.erase(order_id);
 }
 
-void TradingEngine::on_order_traded(uint64_t order_id, int this_traded,
-                                    double traded_price) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(order_id);
-  if (iter == order_map_.end()) {
+void TradingEngine::handle_order_traded(uint64_t order_id, int this_traded,
+                                        double traded_price) {
+  Metrics::add(MC_ORDER_TRADED);
+
+  auto order_ptr = orders_.find(order_id);
+  if (!order_ptr) {
     spdlog::error(
         "[TradingEngine::on_order_traded] Order not found. OrderID: {}, "
         "Traded: {}, Price: {}",
         order_id, this_traded, traded_price);
     return;
   }
-  auto& order = iter->second;
+  auto& order = *order_ptr;
+  latency_.record(LAT_EXCHANGE_FILL, order.sent_time_ns, event_time_ns_);
 
-  spdlog::info(
-      "[TradingEngine::on_order_traded] 报单成交. Ticker: {}, Direction: {}, "
-      "Offset: {}, Traded: {}, Price: {}",
-      order.contract->ticker, direction_str(order.direction),
-      offset_str(order.offset), this_traded, traded_price);
+  EventLogger::log(LOG_ORDER_TRADED, order.contract, order_id,
+                   order.direction, order.offset, this_traded, traded_price);
 
   portfolio_.update_traded(order.contract->index, order.direction, order.offset,
                            this_traded, traded_price);
 
-  if (is_offset_open(order.offset)) {
-    auto margin_rate = order.direction == Direction::BUY
-                           ? order.contract->long_margin_rate
-                           : order.contract->short_margin_rate;
-    auto margin =
-        order.contract->size * this_traded * order.price * margin_rate;
-    account_.frozen -= margin;
-    account_.margin += margin;
-  } else if (is_offset_close(order.offset)) {
-    auto margin_rate = order.direction == Direction::BUY
-                           ? order.contract->long_margin_rate
-                           : order.contract->short_margin_rate;
-    auto margin =
-        order.contract->size * this_traded * traded_price * margin_rate;
-    account_.margin -= margin;
-    if (account_.margin < 0) account_.margin = 0;
-  }
-  spdlog::debug("Account: balance:{} frozen:{} margin:{}", account_.balance,
-                account_.frozen, account_.margin);
+  ledger_.on_traded(order.contract, order.direction, order.offset,
+                    this_traded, order.margin_price, traded_price);
+  log_account();
 
   risk_mgr_->on_order_traded(order.engine_order_id, this_traded, traded_price);
 
   bool completed = false;
   order.traded_volume += this_traded;
   if (order.traded_volume + order.canceled_volume == order.volume) {
-    spdlog::info(
-        "[TradingEngine::on_order_traded] 报单完成. Ticker: {}, Direction: {}, "
-        "Offset: {}, Traded/Original: {}/{}",
-        order.contract->ticker, direction_str(order.direction),
-        offset_str(order.offset), order.traded_volume, order.volume);
+    EventLogger::log(LOG_ORDER_COMPLETED, order.contract, order_id,
+                     order.direction, order.offset, order.traded_volume,
+                     order.volume);
 
     // 订单结束，通知风控模块
     risk_mgr_->on_order_completed(order.engine_order_id, NO_ERROR);
 
     completed = true;
-    order_map_.erase(iter);
   }
 
-  if (order.strategy_id[0] != 0) {
+  if (order.strategy_index != StrategyIdTable::kNone) {
     OrderResponse rsp{};
     rsp.user_order_id = order.user_order_id;
     rsp.order_id = order_id;
+    rsp.cmd_time_ns = order.cmd_time_ns;
     rsp.ticker_index = order.contract->index;
     rsp.direction = order.direction;
     rsp.offset = order.offset;
@@ -431,55 +855,59 @@ void TradingEngine::on_order_traded(uint64_t order_id, int this_traded,
     rsp.this_traded_price = traded_price;
     rsp.completed = completed;
     rsp.error_code = NO_ERROR;
-    rsp_redis_.publish(order.strategy_id, &rsp, sizeof(rsp));
+    publish_rsp(strategy_ids_.name(order.strategy_index), &rsp);
+  }
+
+  if (completed) {
+    if (order.replace_pending) {
+      spdlog::warn(
+          "[TradingEngine::on_order_traded] Replace dropped. OrderID: {}",
+          order_id);
+      respond_replace_failed(order, true);
+    }
+    orders_.erase(order_id);
   }
 }
 
-void TradingEngine::on_order_canceled(uint64_t order_id, int canceled_volume) {
-  std::unique_lock<std::mutex> lock(mutex_);
-  auto iter = order_map_.find(order_id);
-  if (iter == order_map_.end()) {
+void TradingEngine::handle_order_canceled(uint64_t order_id,
+                                          int canceled_volume) {
+  Metrics::add(MC_ORDER_CANCELED);
+
+  auto order_ptr = orders_.find(order_id);
+  if (!order_ptr) {
     spdlog::error(
         "[TradingEngine::on_order_canceled] Order not found. OrderID: {}",
         order_id);
     return;
   }
 
-  auto& order = iter->second;
-  spdlog::info(
-      "[TradingEngine::on_order_canceled] 报单已撤. Ticker: {}, Direction: {}, "
-      "Offset: {}, Canceled: {}",
-      order.contract->ticker, direction_str(order.direction),
-      offset_str(order.offset), canceled_volume);
+  auto& order = *order_ptr;
+  EventLogger::log(LOG_ORDER_CANCELED, order.contract, order_id,
+                   order.direction, order.offset, canceled_volume);
 
   order.canceled_volume = canceled_volume;
   portfolio_.update_pending(order.contract->index, order.direction,
                             order.offset, -order.canceled_volume);
 
   if (is_offset_open(order.offset)) {
-    auto margin_rate = order.direction == Direction::BUY
-                           ? order.contract->long_margin_rate
-                           : order.contract->short_margin_rate;
-    account_.frozen -=
-        order.contract->size * canceled_volume * order.price * margin_rate;
-    spdlog::debug("Account: balance:{} frozen:{} margin:{}", account_.balance,
-                  account_.frozen, account_.margin);
+    ledger_.freeze(order.contract, order.direction, order.offset,
+                   -canceled_volume, order.margin_price);
+    log_account();
   }
 
   if (order.traded_volume + order.canceled_volume == order.volume) {
-    spdlog::info(
-        "[TradingEngine::on_order_canceled] 报单完成. Ticker: {}, Direction: "
-        "{}, Offset: {}, Traded/Original: {}/{}",
-        order.contract->ticker, direction_str(order.direction),
-        offset_str(order.offset), order.traded_volume, order.volume);
+    EventLogger::log(LOG_ORDER_COMPLETED, order.contract, order_id,
+                     order.direction, order.offset, order.traded_volume,
+                     order.volume);
 
     // 订单结束，通知风控模块
     risk_mgr_->on_order_completed(order.engine_order_id, NO_ERROR);
 
-    if (order.strategy_id[0] != 0) {
+    if (order.strategy_index != StrategyIdTable::kNone) {
       OrderResponse rsp{};
       rsp.user_order_id = order.user_order_id;
       rsp.order_id = order_id;
+      rsp.cmd_time_ns = order.cmd_time_ns;
       rsp.ticker_index = order.contract->index;
       rsp.direction = order.direction;
       rsp.offset = order.offset;
@@ -487,33 +915,112 @@ void TradingEngine::on_order_canceled(uint64_t order_id, int canceled_volume) {
       rsp.traded_volume = order.traded_volume;
       rsp.completed = true;
       rsp.error_code = NO_ERROR;
-      rsp_redis_.publish(order.strategy_id, &rsp, sizeof(rsp));
+      publish_rsp(strategy_ids_.name(order.strategy_index), &rsp);
     }
 
-    order_map_.erase(iter);
+    bool replace = order.replace_pending;
+    TraderCommand child{};
+    if (replace) make_replace_cmd(order, &child);
+
+    orders_.erase(order_id);
+
+    // 原订单的冻结已在上面释放，引擎线程中没有其他事件能插入，新订单
+    // 重新冻结后相当于直接继承了原订单的仓位和保证金
+    if (replace) send_orders(&child, &child.order_req, 1);
   }
 }
 
-void TradingEngine::on_order_cancel_rejected(uint64_t order_id) {
+/*
+ * 由改单请求生成新订单的报单指令，新订单的价格类型、方向和开平与原订单
+ * 相同
+ */
+void TradingEngine::make_replace_cmd(const Order& order, TraderCommand* cmd) {
+  cmd->magic = TRADER_CMD_MAGIC;
+  cmd->type = NEW_ORDER;
+  const auto& strategy_id = strategy_ids_.name(order.strategy_index);
+  auto len = std::min(strategy_id.size(), sizeof(cmd->strategy_id) - 1);
+  memcpy(cmd->strategy_id, strategy_id.data(), len);
+  cmd->strategy_id[len] = 0;
+
+  auto& req = cmd->order_req;
+  req.user_order_id = order.replace_user_order_id != 0
+                          ? order.replace_user_order_id
+                          : order.user_order_id;
+  req.ticker_index = order.contract->index;
+  req.direction = order.direction;
+  req.offset = order.offset;
+  req.type = order.type;
+  // 原订单已成交的部分不再重复报出
+  req.volume = order.replace_volume > 0
+                   ? std::min(order.replace_volume, order.canceled_volume)
+                   : order.canceled_volume;
+  req.price = order.replace_price;
+
+  EventLogger::log(LOG_ORDER_REPLACED, order.contract, order.order_id,
+                   order.direction, order.offset, order.price, req.price,
+                   req.volume);
+}
+
+void TradingEngine::handle_order_cancel_rejected(uint64_t order_id) {
+  Metrics::add(MC_CANCEL_REJECTED);
+
   spdlog::warn(
       "[TradingEngine::on_order_cancel_rejected] Order cannot be canceled. "
       "OrderID: {}",
       order_id);
+
+  // 撤单失败时改单也随之放弃，原订单保持不变
+  auto order = orders_.find(order_id);
+  if (order && order->replace_pending) {
+    spdlog::warn(
+        "[TradingEngine::on_order_cancel_rejected] Replace dropped. "
+        "OrderID: {}",
+        order_id);
+    order->replace_pending = false;
+    respond_replace_failed(*order, false);
+  }
+}
+
+void TradingEngine::respond_replace_failed(const Order& order,
+                                           bool completed) {
+  if (order.strategy_index == StrategyIdTable::kNone) return;
+
+  OrderResponse rsp{};
+  rsp.user_order_id = order.replace_user_order_id != 0
+                          ? order.replace_user_order_id
+                          : order.user_order_id;
+  rsp.order_id = order.order_id;
+  rsp.ticker_index = order.contract->index;
+  rsp.direction = order.direction;
+  rsp.offset = order.offset;
+  rsp.original_volume = order.volume;
+  rsp.traded_volume = order.traded_volume;
+  rsp.completed = completed;
+  rsp.error_code = ERR_REPLACE_FAILED;
+  publish_rsp(strategy_ids_.name(order.strategy_index), &rsp);
 }
 
 void TradingEngine::respond_send_order_error(const TraderCommand* cmd,
+                                             const TraderOrderReq& sreq,
                                              int error_code) {
   if (cmd->strategy_id[0] == 0) return;
 
   OrderResponse rsp{};
-  rsp.user_order_id = cmd->order_req.user_order_id;
-  rsp.ticker_index = cmd->order_req.ticker_index;
-  rsp.direction = cmd->order_req.direction;
-  rsp.offset = cmd->order_req.offset;
-  rsp.original_volume = cmd->order_req.volume;
+  rsp.user_order_id = sreq.user_order_id;
+  rsp.ticker_index = sreq.ticker_index;
+  rsp.direction = sreq.direction;
+  rsp.offset = sreq.offset;
+  rsp.original_volume = sreq.volume;
   rsp.completed = true;
   rsp.error_code = error_code;
-  rsp_redis_.publish(cmd->strategy_id, &rsp, sizeof(rsp));
+  rsp.cmd_time_ns = cmd->send_time_ns;
+  publish_rsp(cmd->strategy_id, &rsp);
+}
+
+void TradingEngine::publish_rsp(const std::string& strategy_id,
+                                OrderResponse* rsp) {
+  rsp->rsp_time_ns = latency_.now();
+  rsp_pub_->publish(strategy_id, rsp);
 }
 
 }  // namespace ft
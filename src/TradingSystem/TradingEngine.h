@@ -4,21 +4,28 @@
 #define FT_SRC_TRADINGSYSTEM_TRADINGENGINE_H_
 
 #include <list>
-#include <map>
 #include <memory>
-#include <mutex>
 #include <string>
 #include <vector>
 
+#include "Common/AccountLedger.h"
+#include "Common/LatencyStats.h"
+#include "Common/OrderRspTransport.h"
 #include "Common/PositionManager.h"
+#include "Common/QuoteTable.h"
+#include "Common/QuoteTransport.h"
+#include "Common/TraderCmdTransport.h"
 #include "Core/Account.h"
 #include "Core/Config.h"
 #include "Core/ErrorCode.h"
 #include "Core/Gateway.h"
 #include "Core/RiskManagementInterface.h"
 #include "Core/TradingEngineInterface.h"
-#include "IPC/redis.h"
+#include "IPC/MpscQueue.h"
+#include "IPC/SharedMemory.h"
+#include "TradingSystem/AsyncPublisher.h"
 #include "TradingSystem/Order.h"
+#include "TradingSystem/OrderStore.h"
 
 namespace ft {
 
@@ -35,14 +42,86 @@ class TradingEngine : public TradingEngineInterface {
   void close();
 
  private:
+  /*
+   * 网关的订单回调和策略的交易指令都先放入同一个无锁的入站队列，由引擎
+   * 线程(即调用run的线程)依次处理。orders_、ledger_、portfolio_及
+   * 风控模块只在引擎线程中访问，不需要加锁，回调线程只负责入队
+   *
+   * 行情不经过入站队列，由网关回调线程直接发布，并写入以下按合约的价格
+   * 缓存，它们都是relaxed原子变量，引擎线程可以随时读取：
+   * PriceLimitRule的涨跌停板及最新价、ledger_和portfolio_的最新价
+   */
+  enum EngineEventType : uint32_t {
+    EV_TRADER_CMD = 1,
+    EV_ORDER_ACCEPTED,
+    EV_ORDER_REJECTED,
+    EV_ORDER_TRADED,
+    EV_ORDER_CANCELED,
+    EV_ORDER_CANCEL_REJECTED,
+    EV_BATCH_ORDER_REQ  // 紧跟在NEW_ORDER_BATCH指令之后的一笔订单
+  };
+
+  struct EngineEvent {
+    uint32_t type;
+    uint64_t time_ns;  // 入队时间，仅在开启延迟追踪时设置
+    union {
+      TraderCommand cmd;
+      TraderOrderReq order_req;
+      struct {
+        uint64_t order_id;
+        int volume;
+        double price;
+      } order;
+    };
+  };
+
+  static constexpr std::size_t kEventQueueSize = 16384;
+  static constexpr uint32_t kMaxPendingOrders = 65536;
+  static constexpr uint64_t kWaitTimeoutMs = 100;
+  using EventQueue = MpscQueue<EngineEvent, kEventQueueSize>;
+
+  void push_event(const EngineEvent& event);
+
+  void push_events(const EngineEvent* events, std::size_t n);
+
+  void process_event(const EngineEvent& event);
+
+  void process_cmd(const TraderCommand* cmd);
+
+  void process_batch_cmd(const TraderCommand& cmd);
+
+  void recv_cmd();
+
   bool send_order(const TraderCommand* cmd);
 
+  void send_order_batch(const TraderCommand* cmd);
+
+  uint32_t send_orders(const TraderCommand* cmd, const TraderOrderReq* sreqs,
+                       uint32_t count);
+
+  void freeze_order(const Contract* contract, const OrderReq& req, int volume,
+                    double margin_price);
+
+  void log_account();
+
+  void mark_to_market_if_due();
+
   void cancel_order(uint64_t order_id);
 
+  void replace_order(const TraderCommand* cmd);
+
+  void make_replace_cmd(const Order& order, TraderCommand* cmd);
+
+  void respond_replace_failed(const Order& order, bool completed);
+
   void cancel_for_ticker(uint32_t ticker_index);
 
   void cancel_all();
 
+  void cancel_strategy(const char* strategy_id);
+
+  void query_orders(const char* strategy_id);
+
   void on_query_contract(const Contract* contract) override;
 
   void on_query_account(const Account* account) override;
@@ -64,27 +143,65 @@ class TradingEngine : public TradingEngineInterface {
 
   void on_order_cancel_rejected(uint64_t order_id) override;
 
+  void handle_order_accepted(uint64_t order_id);
+
+  void handle_order_rejected(uint64_t order_id);
+
+  void handle_order_traded(uint64_t order_id, int this_traded,
+                           double traded_price);
+
+  void handle_order_canceled(uint64_t order_id, int canceled_volume);
+
+  void handle_order_cancel_rejected(uint64_t order_id);
+
  private:
   uint64_t next_engine_order_id() { return next_engine_order_id_++; }
 
+  /*
+   * 开启延迟追踪时在回报中记录发出时间
+   */
+  void publish_rsp(const std::string& strategy_id, OrderResponse* rsp);
+
   void respond_send_order_error(const TraderCommand* cmd,
+                                const TraderOrderReq& sreq,
                                 int error_code = NO_ERROR);
 
  private:
   std::unique_ptr<Gateway> gateway_{nullptr};
 
   ProtocolQueryCenter proto_{};
-  Account account_{};
+  AccountLedger ledger_{};
   PositionManager portfolio_;
   std::unique_ptr<RiskManagementInterface> risk_mgr_{nullptr};
-  std::map<uint64_t, Order> order_map_{};
-  std::mutex mutex_{};
+  OrderStore orders_{kMaxPendingOrders};
+  StrategyIdTable strategy_ids_{};
+
+  // 报单时使用的临时缓冲区，只在引擎线程中使用
+  TraderCmdBuffer batch_cmd_{};
+  OrderReq pending_reqs_[kMaxBatchOrders];
+  uint64_t pending_order_ids_[kMaxBatchOrders];
+  uint32_t pending_legs_[kMaxBatchOrders];
+  double pending_margin_prices_[kMaxBatchOrders];
 
   uint64_t next_engine_order_id_{1};
 
-  RedisSession tick_redis_{};
-  RedisSession order_redis_{};
-  RedisSession rsp_redis_{};
+  // async_pub_须先于quote_pub_和rsp_pub_构造、晚于它们析构
+  std::unique_ptr<AsyncPublisher> async_pub_{nullptr};
+  std::unique_ptr<QuotePublisher> quote_pub_{nullptr};
+  std::unique_ptr<TraderCmdReceiver> cmd_receiver_{nullptr};
+  SharedMemory quote_table_shm_;
+  QuoteTable* quote_table_{nullptr};
+  std::unique_ptr<OrderRspPublisher> rsp_pub_{nullptr};
+
+  std::unique_ptr<EventQueue> event_queue_{nullptr};
+  bool futex_wait_ = false;
+  uint64_t pnl_interval_ms_ = 0;
+  uint64_t next_pnl_ms_ = 0;
+  int cpu_affinity_ = -1;
+
+  // 只在引擎线程中记录，其他线程只读取是否开启
+  LatencyTracer latency_;
+  uint64_t event_time_ns_ = 0;  // 正在处理的事件的入队时间
 
   std::atomic<bool> is_logon_{false};
 };